@@ -1,12 +1,25 @@
 /*
  * File:    LCD_KS0108_drv.c
  *
- * Low-level driver functions for monochrome Graphic LCD module, 128 x 64 pixels.
+ * Low-level driver functions for monochrome Graphic LCD module, 128 x 64 pixels
+ * (or LCD_WIDTH x LCD_HEIGHT -- see LCD_buffer_def.h).
  *
  * Customized for LCD controller chip-set:  KS0107, KS0108.
  */
+#include <string.h>
 #include "LCD_KS0108_drv.h"
 
+#ifdef LCD_USE_SHADOW_GDRAM
+// Copy of KS0108 GDRAM contents, both chips (ordered as [page][x])
+static  uint8  shadowGDRAM[LCD_PAGES][LCD_WIDTH];
+#endif
+
+PRIVATE  void  LCD_WritePageSpan(uint8 page, int firstCol, uint8 *pSeg, int count);
+PRIVATE  void  LCD_WriteSegments(uint8 page, uint8 x, uint8 *data, int count);
+#ifndef LCD_BUFFER_PAGE_MAJOR
+PRIVATE  void  LCD_TransposePage(scnword_t *pRows, int firstCol, int lastCol, uint8 *segData);
+#endif
+
 
 /*----------------------------------------------------------------------------------
  * Name               :  LCD_WaitNotBusy()
@@ -150,12 +163,14 @@ bool  LCD_Init(void)
     if ( LCD_ReadStatus() & LCD_STATUS_OFF ) result = 0;
     LCD_CS1_OFF();
     
+#if LCD_WIDTH > 64
     LCD_CS2_ON();
     if ( !(LCD_ReadStatus() & LCD_STATUS_OFF) ) result = 0;
     LCD_WriteCommand(LCD_SET_DISPLAY_ON);    // Turn on graphics mode
     LCD_WriteCommand(LCD_SET_START_LINE);    // Set "Start Line" = 0
     if ( LCD_ReadStatus() & LCD_STATUS_OFF ) result = 0;
     LCD_CS2_OFF();
+#endif
 
     return result;
 }
@@ -184,12 +199,13 @@ bool  LCD_Init(void)
  *
  *  ^NB: In the Samsung KS0108B datasheet, "Y-ADDRESS" = horizontal address!
  *
+ *  Only the pages (and chips) used by the panel, LCD_PAGES x LCD_WIDTH, are cleared.
 ------------------------------------------------------------------------------------*/
 void   LCD_ClearGDRAM(void)
 {
     int   y_addr, page;
 
-    for (page = 0;  page < 8;  page++)
+    for (page = 0;  page < LCD_PAGES;  page++)
     {
         LCD_CS1_ON();   // Select Left Half Screen (LHS)
         LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);  // vert addr
@@ -200,6 +216,7 @@ void   LCD_ClearGDRAM(void)
         }
         LCD_CS1_OFF();
 
+#if LCD_WIDTH > 64
         LCD_CS2_ON();   // Select Right Half Screen (RHS)
         LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);  // vert addr
         LCD_WriteCommand(LCD_SET_Y_ADDR | 0);   // horiz addr
@@ -208,7 +225,12 @@ void   LCD_ClearGDRAM(void)
             LCD_WriteData(0);  // Y-ADDRESS auto increments
         }
         LCD_CS2_OFF();
+#endif
     }
+
+#ifdef LCD_USE_SHADOW_GDRAM
+    memset(shadowGDRAM, 0, sizeof(shadowGDRAM));
+#endif
 }
 
 
@@ -229,27 +251,27 @@ void   LCD_ClearGDRAM(void)
  * Notes:     :  The (external) screen buffer is formatted as 8 "columns" horizonally
  *               by 64 "rows" vertically. Each column has 16 pixels. The leftmost
  *               pixel is stored in the MS bit (bit15) of the column.
+ *               If LCD_BUFFER_PAGE_MAJOR is defined, the buffer is in GDRAM format,
+ *               8 pages x 128 bytes, and is copied without transformation.
 ------------------------------------------------------------------------------------*/
-void   LCD_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
+void   LCD_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
 {
     uint8   page;                   // page address in KS0108 (1 page = 8 rows)
-    uint8   x_coord;                // pixel horizontal coordinate
-    int     row, col;               // row and column word index for screen buffer
     int     firstPage;              // first (top) page to be modified
     int     lastPage;               // last (bottom) page to be modified
     int     firstCol;               // first (leftmost) column in a row to be modified
     int     lastCol;                // last (rightmost) column in a row to be modified
-    int     offset;                 // address offset of pixel word in scnBuf
-    uint8   pixelByte;              // 8 pixels aligned vertically (LS bit at top)
-    uint8   bitmask;
-    uint16  pixelWord[8];           // 8 rows x 16 pixels in a column to be modified
-    uint16  *pBuf;
+    uint8   *pSeg;                  // data for 1 page, cols firstCol..lastCol
+    int     count;                  // number of bytes in page span
+#ifndef LCD_BUFFER_PAGE_MAJOR
+    uint8   segData[(LCD_WIDTH + 15) & ~15];   // transposed pixels for 1 page
+#endif
 
-    if (y > 63)  y = 0;             // prevent writing past end-of-screen
-    if ((y + h) > 63)  h = 63 - y;
+    if (y >= LCD_HEIGHT)  y = 0;    // prevent writing past end-of-screen
+    if ((y + h) > LCD_HEIGHT)  h = LCD_HEIGHT - y;
 
-    if (x > 127)  x = 0;            // prevent writing past end-of-row
-    if ((x + w) > 128)  w = 128 - x;
+    if (x >= LCD_WIDTH)  x = 0;     // prevent writing past end-of-row
+    if ((x + w) > LCD_WIDTH)  w = LCD_WIDTH - x;
 
     firstPage = y / 8;
     lastPage = (y + h - 1) / 8;
@@ -259,49 +281,188 @@ void   LCD_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
 
     for (page = firstPage;  page <= lastPage;  page++)
     {
-        for (col = firstCol;  col <= lastCol && col < 8;  col++)
+        count = (lastCol - firstCol + 1) * 16;
+        if ((firstCol * 16 + count) > LCD_WIDTH)  count = LCD_WIDTH - firstCol * 16;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+        pSeg = scnBuf + page * LCD_WIDTH + firstCol * 16;   // buffer is in GDRAM format
+#else
+        pSeg = segData;
+        LCD_TransposePage(scnBuf + page * 8 * SCN_ROW_WORDS, firstCol, lastCol, segData);
+#endif
+        LCD_WritePageSpan(page, firstCol, pSeg, count);
+    }
+}
+
+
+#if defined LCD_BUFFER_PAGE_MAJOR || defined LCD_ROTATION
+/*----------------------------------------------------------------------------------
+ * Function   :  LCD_WriteStrip()
+ *
+ * Overview   :  Copies one page of pixels (LCD_WIDTH x 8), rendered in a strip buffer
+ *               in screen buffer format, to the KS0108 GDRAM (both chips).  Used in
+ *               page mode (LCD_PAGE_MODE), where the graphics library has no full
+ *               screen buffer, and to write the screen in rotated orientation
+ *               (LCD_ROTATION).
+ *
+ * Input      :  strip = address of LCD_WIDTH bytes (8 pixels vertical each, bit 0 at top)
+ *                       or, if row-major, 8 rows of SCN_ROW_WORDS words
+ *               page = page address (0..LCD_PAGES-1)
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+void   LCD_WriteStrip(scnword_t *strip, uint8 page)
+{
+#ifndef LCD_BUFFER_PAGE_MAJOR
+    uint8   segData[(LCD_WIDTH + 15) & ~15];   // transposed pixels for 1 page
+#endif
+
+    if (page >= LCD_PAGES)  return;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_WritePageSpan(page, 0, strip, LCD_WIDTH);
+#else
+    LCD_TransposePage(strip, 0, (LCD_WIDTH - 1) / 16, segData);
+    LCD_WritePageSpan(page, 0, segData, LCD_WIDTH);
+#endif
+}
+#endif
+
+
+#ifndef LCD_BUFFER_PAGE_MAJOR
+/*----------------------------------------------------------------------------------
+ * Function   :  LCD_TransposePage()
+ *
+ * Overview   :  Transposes the pixels in one page (8 rows) of a row-major screen
+ *               buffer, columns firstCol..lastCol (16 pixels each), to GDRAM format,
+ *               i.e. one byte per segment, 8 pixels vertical, bit 0 at the top.
+ *
+ * Input      :  pRows = address of the first row of the page in the buffer
+ *               firstCol, lastCol = first and last column (16 pixels) to transpose
+ * Output     :  segData = 16 bytes per column, leftmost segment first
+------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_TransposePage(scnword_t *pRows, int firstCol, int lastCol, uint8 *segData)
+{
+    int     col;                    // column index (16 pixels) in screen buffer
+    int     row;                    // row index in page
+    uint8   x_coord;                // pixel horizontal coordinate
+    uint8   pixelByte;              // 8 pixels aligned vertically (LS bit at top)
+    uint8   bitmask;
+    uint16  pixelWord[8];           // 8 rows x 16 pixels in a column to be modified
+    scnword_t  *pBuf;
+    int     shift;                  // bits to shift buffer word to get 16 pixels
+    uint8   *pSeg = segData;
+
+    for (col = firstCol;  col <= lastCol;  col++)
+    {
+        // Grab a bunch of 16 (H) x 8 (V) pixels from buffer...
+        shift = SCN_WORD_BITS - 16 - (col * 16) % SCN_WORD_BITS;  // 16 or 0 if 32-bit
+        pBuf = pRows + (col * 16) / SCN_WORD_BITS;
+        for (row = 0;  row < 8;  row++)  // 8 rows in LCD page
         {
-            // Grab a bunch of 16 (H) x 8 (V) pixels from buffer...
-            offset = page * 64 + col;  // 64 words per buffer "page"
-            pBuf = scnBuf + offset;
-            for (row = 0;  row < 8;  row++)  // 8 rows in LCD page
-            {
-                pixelWord[row] = *pBuf;
-                pBuf += 8;  // next row (advance 8 col's)
-            }
+            pixelWord[row] = (uint16) (*pBuf >> shift);
+            pBuf += SCN_ROW_WORDS;  // next row
+        }
 
-            if (col < 4)  // select LHS controller chip
-            {
-                LCD_CS1_ON();
-                LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);   // vert (page) addr
-                LCD_WriteCommand(LCD_SET_Y_ADDR | col * 16);  // horiz (Y) addr
-            }
-            else  // select RHS controller chip
-            {
-                LCD_CS2_ON();
-                LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);   // vert (page) addr
-                LCD_WriteCommand(LCD_SET_Y_ADDR | (col - 4) * 16);  // horiz (Y) addr
-            }
-            // Write a bunch of pixels 16 (H) x 8 (V) to selected KS0108 chip
-            for (x_coord = 0;  x_coord < 16;  x_coord++)
+        for (x_coord = 0;  x_coord < 16;  x_coord++)
+        {
+            // transpose horiz pixels in pixelWord[8] to vertical pixelByte
+            pixelByte = 0;
+            bitmask = 0x01;
+            for (row = 0;  row < 8;  row++)
             {
-                // transpose horiz pixels in pixelWord[8] to vertical pixelByte
-                pixelByte = 0;
-                bitmask = 0x01;
-                for (row = 0;  row < 8;  row++)
-                {
-                    if (pixelWord[row] & 0x8000) pixelByte |= bitmask;
-                    bitmask = bitmask << 1;   // next pixel down
-                    pixelWord[row] = pixelWord[row] << 1;  // next pixel right
-                }
-                // write 8 pixels vertically to KS0108 chip
-                LCD_WriteData(pixelByte);  // Y-ADDRESS auto increments
+                if (pixelWord[row] & 0x8000) pixelByte |= bitmask;
+                bitmask = bitmask << 1;   // next pixel down
+                pixelWord[row] = pixelWord[row] << 1;  // next pixel right
             }
-            LCD_CS1_OFF();  // de-select both KS0108 chips
-            LCD_CS2_OFF();
+            *pSeg++ = pixelByte;   // 8 pixels vertically
         }
     }
 }
+#endif
+
+
+/*----------------------------------------------------------------------------------
+ * Function   :  LCD_WritePageSpan()
+ *
+ * Overview   :  Writes a span of bytes, in whole columns of 16 pixels, to one page of
+ *               KS0108 GDRAM.  If LCD_USE_SHADOW_GDRAM is defined, only the runs of
+ *               bytes which differ from the GDRAM contents are written.
+ *               The last column is partial if the span ends at the right edge of a
+ *               panel whose width is not a multiple of 16.
+ *
+ * Input      :  page = page address (0..7),  firstCol = first column (0..7)
+ *               pSeg = pointer to segment data,  count = number of bytes (16 x cols)
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_WritePageSpan(uint8 page, int firstCol, uint8 *pSeg, int count)
+{
+#ifdef LCD_USE_SHADOW_GDRAM
+    int     i, first, last;         // index of first and last bytes in a run of changes
+    int     chipEnd;                // index of first byte past the current chip (CS1/CS2)
+    uint8   *pShadow;
+
+    // Write only the runs of bytes which differ from the GDRAM (shadow) contents.
+    // A run may include short unchanged gaps, but may not span both KS0108 chips.
+    pShadow = &shadowGDRAM[page][firstCol * 16];
+
+    for (i = 0;  i < count;  )
+    {
+        if (pSeg[i] == pShadow[i])  { i++;  continue; }
+
+        chipEnd = (4 - firstCol) * 16;   // index of first byte in RHS chip
+        if (i >= chipEnd || chipEnd > count)  chipEnd = count;
+        first = last = i;
+        for (i++;  i < chipEnd && (i - last) <= KS0108_SHADOW_MAX_GAP;  i++)
+        {
+            if (pSeg[i] != pShadow[i])  last = i;
+        }
+
+        LCD_WriteSegments(page, firstCol * 16 + first, &pSeg[first], last - first + 1);
+        memcpy(&pShadow[first], &pSeg[first], last - first + 1);
+        i = last + 1;
+    }
+#else
+    int     col;                    // column index (16 pixels) in span
+    int     n;                      // number of bytes in column
+
+    // Write bunches of pixels, 16 (H) x 8 (V), to KS0108 chips
+    for (col = firstCol;  (col - firstCol) * 16 < count;  col++)
+    {
+        n = count - (col - firstCol) * 16;
+        LCD_WriteSegments(page, col * 16, &pSeg[(col - firstCol) * 16], (n < 16) ? n : 16);
+    }
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Function   :  LCD_WriteSegments()
+ *
+ * Overview   :  Writes a sequence of data bytes (8 vertical pixels each) to one page
+ *               of KS0108 GDRAM, starting at pixel column x.  The bytes must all
+ *               lie within one half of the screen, i.e. in one KS0108 chip.
+ *
+ * Input      :  page = page address (0..7),  x = pixel horizontal coordinate (0..127)
+ *               data = pointer to data bytes,  count = number of bytes to write
+ *
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_WriteSegments(uint8 page, uint8 x, uint8 *data, int count)
+{
+    if (x < 64)  LCD_CS1_ON();      // select LHS controller chip
+    else  LCD_CS2_ON();             // select RHS controller chip
+
+    LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);      // vert (page) addr
+    LCD_WriteCommand(LCD_SET_Y_ADDR | (x & 63));     // horiz (Y) addr
+
+    while (count-- > 0)
+    {
+        LCD_WriteData(*data++);  // Y-ADDRESS auto increments
+    }
+
+    LCD_CS1_OFF();  // de-select both KS0108 chips
+    LCD_CS2_OFF();
+}
 
 
 /*----------------------------------------------------------------------------------
@@ -318,29 +479,37 @@ void  LCD_Test()
     
     LCD_ClearGDRAM();
 
-    for (page = 0;  page < 8;  page++)
+    for (page = 0;  page < LCD_PAGES;  page++)
     {
         LCD_CS1_ON();   // Select Left Half Screen (LHS)
         LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);  // vert addr
         LCD_WriteCommand(LCD_SET_Y_ADDR | 0);   // horiz addr
-        for (x_coord = 0;  x_coord < 64;  x_coord++)
+        for (x_coord = 0;  x_coord < 64 && x_coord < LCD_WIDTH;  x_coord++)
         {
             if ((x_coord % 8) == 0) pixels = 0x01;
             LCD_WriteData(pixels);
+#ifdef LCD_USE_SHADOW_GDRAM
+            shadowGDRAM[page][x_coord] = pixels;
+#endif
             pixels = pixels << 1;  // move 1 pixel down
         }
         LCD_CS1_OFF();
 
+#if LCD_WIDTH > 64
         LCD_CS2_ON();   // Select Right Half Screen (RHS)
         LCD_WriteCommand(LCD_SET_PAGE_ADDR | page);  // vert addr
         LCD_WriteCommand(LCD_SET_Y_ADDR | 0);   // horiz addr
-        for (x_coord = 0;  x_coord < 64;  x_coord++)
+        for (x_coord = 0;  x_coord < (LCD_WIDTH - 64);  x_coord++)
         {
             if ((x_coord % 8) == 0) pixels = 0x01;
             LCD_WriteData(pixels);
+#ifdef LCD_USE_SHADOW_GDRAM
+            shadowGDRAM[page][x_coord + 64] = pixels;
+#endif
             pixels = pixels << 1;  // move 1 pixel down
         }
         LCD_CS2_OFF();
+#endif
     }
 }
 
@@ -1,7 +1,8 @@
 /*
  * File:    LCD_KS0108_drv.h
  *
- * Low-level driver def's for monochrome Graphic LCD module, 128 x 64 pixels.
+ * Low-level driver def's for monochrome Graphic LCD module, 128 x 64 pixels
+ * (or LCD_WIDTH x LCD_HEIGHT -- see LCD_buffer_def.h).
  *
  * Adapted for KS0108 LCD controller chipset and PIC32MX micro-controller.
  */
@@ -10,10 +11,25 @@
 
 #include "../Common/GenericTypeDefs.h"
 #include "../Common/system_def.h"
+#include "LCD_buffer_def.h"          // screen buffer format
 
 // Comment out the next line for Active-High Chip Select...
 //#define LCD_CHIPSELECT_ACTIVE_LOW  1
 
+// Uncomment the next line to keep a copy of the KS0108 GDRAM in MCU RAM (1024 bytes).
+// LCD_WriteBlock() then sends only the bytes which differ from the GDRAM contents.
+//#define LCD_USE_SHADOW_GDRAM  1
+
+// Unchanged bytes between two changed runs are re-sent if the gap is no longer than this;
+// starting a new run costs 2 command writes (page and Y address).
+#define KS0108_SHADOW_MAX_GAP   2
+
+// Each KS0108 drives 64 columns;  the module has one chip (CS1) if it is up to 64 pixels
+// wide, else two (CS1 = LHS, CS2 = RHS).
+#if LCD_WIDTH > 128
+#error "KS0108 driver supports panels up to 128 pixels wide (2 chips)!"
+#endif
+
 #define LCD_CTRL_DIRN_OUT()    (TRISD &= ~(0x7F << 5))   // RD5..RD11
 #define LCD_DATA_DIRN_IN()     (TRISE |= 0x00FF)
 #define LCD_DATA_DIRN_OUT()    (TRISE &= ~0x00FF)
@@ -69,7 +85,10 @@ uint8   LCD_ReadStatus();
 void    LCD_Reset(void);
 bool    LCD_Init(void);
 void    LCD_ClearGDRAM();
-void    LCD_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+void    LCD_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+#if defined LCD_BUFFER_PAGE_MAJOR || defined LCD_ROTATION
+void    LCD_WriteStrip(scnword_t *strip, uint8 page);   // 1 page (LCD_WIDTH x 8 pixels)
+#endif
 void    LCD_Test();
 void    LCD_BacklightToggle();
 
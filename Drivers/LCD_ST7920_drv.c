@@ -1,12 +1,21 @@
 /*
  * File:    LCD_ST7920_drv.c
  *
- * Low-level driver functions for monochrome Graphic LCD module, 128 x 64 pixels.
+ * Low-level driver functions for monochrome Graphic LCD module, 128 x 64 pixels
+ * (or LCD_WIDTH x LCD_HEIGHT -- see LCD_buffer_def.h).
  *
  * Customized for LCD controller silicon:  ST7920.
  */
+#include <string.h>
 #include "LCD_ST7920_drv.h"
 
+#ifdef LCD_USE_SHADOW_GDRAM
+// Copy of ST7920 GDRAM contents, ordered the same as the MCU screen buffer
+static  uint16  shadowGDRAM[LCD_HEIGHT][ST7920_COLS];
+#endif
+
+PRIVATE  void  LCD_WriteRow(scnword_t *pRow, int row, int firstCol, int lastCol);
+
 
 /*----------------------------------------------------------------------------------
  * Name               :  Delay_2xTCY()
@@ -196,30 +205,33 @@ bool  LCD_Init(void)
  *        .            .              .            .
  *       31         0 .. 7           31         8 .. 15
  * 
+ * (128 x 64 panel.  A panel up to 32 rows high has no lower half;  only the rows and
+ * column-words shown on the panel are cleared, except that on a panel narrower than
+ * 128 pixels the unseen upper-half words ST7920_COLS .. 7 are also cleared.)
 ------------------------------------------------------------------------------------*/
 void   LCD_ClearGDRAM(void)
 {
     uint8    x, y;
+    uint8    words = (LCD_HEIGHT > 32) ? 8 + ST7920_COLS : ST7920_COLS;
 
-    for (y = 0;  y < 64;  y++)
+    // The horizontal address auto-increments from the upper half of the screen into
+    // the lower half (8 .. 15), so both rows at each vertical address are cleared
+    // after a single address set.
+    for (y = 0;  y < LCD_HEIGHT && y < 32;  y++)
     {
-        if (y < 32)
-        {
-            LCD_WriteCommand(0x80 | y);
-            LCD_WriteCommand(0x80);
-        }
-        else
-        {
-            LCD_WriteCommand(0x80 | (y - 32));
-            LCD_WriteCommand(0x80 + 8);
-        }
+        LCD_WriteCommand(0x80 | y);
+        LCD_WriteCommand(0x80);
 
-        for (x = 0;  x < 8;  x++)
+        for (x = 0;  x < words;  x++)
         {
             LCD_WriteData(0);
             LCD_WriteData(0);
         }
     }
+
+#ifdef LCD_USE_SHADOW_GDRAM
+    memset(shadowGDRAM, 0, sizeof(shadowGDRAM));
+#endif
 }
 
 
@@ -237,36 +249,95 @@ void   LCD_ClearGDRAM(void)
  *  
  * Return     :  --
 ------------------------------------------------------------------------------------*/
-void   LCD_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
+void   LCD_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
 {
-    uint8   vertAddr, horizAddr;    // row and column address to be sent to ST7920
-    int     row, col;               // row and column word index for screen buffer
+    int     row;                    // row index for screen buffer
     int     firstCol;               // first (leftmost) column-word in a row to be modified
     int     lastCol;                // last (rightmost) column-word in a row to be modified
-    uint16  pixelWord;              // row of 16 pixels in column-word to be modified
-    uint16  *pBuf;
 
-    if (x > 127)  x = 0;            // prevent writing past end-of-row
-    if ((x + w) > 128) w = 128 - x;
+    if (x >= LCD_WIDTH)  x = 0;     // prevent writing past end-of-row
+    if ((x + w) > LCD_WIDTH) w = LCD_WIDTH - x;
 
     firstCol = x / 16;   
     lastCol = (x + w - 1) / 16;
 
-    for (row = y;  row < (y + h) && row < 64;  row++)
+    for (row = y;  row < (y + h) && row < LCD_HEIGHT;  row++)
     {
-        for (col = firstCol;  col <= lastCol && col < 8;  col++)
-        {
-            pBuf = scnBuf + (row * 8 + col);
-            pixelWord = *pBuf;
+        LCD_WriteRow(scnBuf + row * SCN_ROW_WORDS, row, firstCol, lastCol);
+    }
+}
+
+
+#ifdef LCD_ROTATION
+/*----------------------------------------------------------------------------------
+ * Function   :  LCD_WriteStrip()
+ *
+ * Overview   :  Copies one page of pixels (LCD_WIDTH x 8), rendered in a strip buffer
+ *               in screen buffer format, to the GDRAM.  Used by the graphics library
+ *               to write the screen in rotated orientation (LCD_ROTATION).
+ *
+ * Input      :  strip = address of 8 rows of SCN_ROW_WORDS words
+ *               page = page address (0..LCD_PAGES-1), i.e. rows page*8..page*8+7
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+void   LCD_WriteStrip(scnword_t *strip, uint8 page)
+{
+    int     row;
+
+    if (page >= LCD_PAGES)  return;
+
+    for (row = 0;  row < 8;  row++)
+    {
+        LCD_WriteRow(strip + row * SCN_ROW_WORDS, page * 8 + row, 0, ST7920_COLS - 1);
+    }
+}
+#endif
+
+
+/*----------------------------------------------------------------------------------
+ * Function   :  LCD_WriteRow()
+ *
+ * Overview   :  Copies a span of column-words in one row of pixels to the GDRAM.
+ *
+ * Input      :  pRow = address of the row in the screen buffer (or strip)
+ *               row = GDRAM row (0..LCD_HEIGHT-1)
+ *               firstCol, lastCol = first and last column-word (16 pixels) to copy
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_WriteRow(scnword_t *pRow, int row, int firstCol, int lastCol)
+{
+    uint8   vertAddr, horizAddr;    // row and column address to be sent to ST7920
+    int     col;                    // column word index for screen buffer
+    uint16  pixelWord;              // row of 16 pixels in column-word to be modified
+    scnword_t  *pBuf;
+#ifdef LCD_USE_SHADOW_GDRAM
+    bool    addrValid = FALSE;      // True => GDRAM address already points to col
+#endif
 
+    for (col = firstCol;  col <= lastCol;  col++)
+    {
+        pBuf = pRow + (col * 16) / SCN_WORD_BITS;
+        pixelWord = (uint16) (*pBuf >> (SCN_WORD_BITS - 16 - (col * 16) % SCN_WORD_BITS));
+
+#ifdef LCD_USE_SHADOW_GDRAM
+        // Skip words which are unchanged in GDRAM;  the horizontal address
+        // auto-increments, so a run of changed words needs only one address.
+        if (pixelWord == shadowGDRAM[row][col])  { addrValid = FALSE;  continue; }
+        shadowGDRAM[row][col] = pixelWord;
+        if (!addrValid)
+#endif
+        {
             if (row < 32)  { vertAddr = row;  horizAddr = col; }  // Top half of screen
             else  { vertAddr = row - 32;  horizAddr = col + 8; }  // Bottom half
 
             LCD_WriteCommand(0x80 | vertAddr);
             LCD_WriteCommand(0x80 | horizAddr);
-            LCD_WriteData(HI_BYTE(pixelWord));
-            LCD_WriteData(LO_BYTE(pixelWord));
         }
+#ifdef LCD_USE_SHADOW_GDRAM
+        addrValid = TRUE;
+#endif
+        LCD_WriteData(HI_BYTE(pixelWord));
+        LCD_WriteData(LO_BYTE(pixelWord));
     }
 }
 
@@ -284,11 +355,11 @@ void  LCD_Test()
     int     row, col;               // row and column word index for screen buffer
     uint16  pixelWord;
 
-    for (row = 0;  row < 64;  row++)
+    for (row = 0;  row < LCD_HEIGHT;  row++)
     {
         if ((row % 16) == 0) pixelWord = 0xC000;
 
-        for (col = 0;  col < 8;  col++)
+        for (col = 0;  col < ST7920_COLS;  col++)
         {
             if (row < 32)  { vertAddr = row;  horizAddr = col; }  // Top half of screen
             else  { vertAddr = row - 32;  horizAddr = col + 8; }  // Bottom half
@@ -297,6 +368,9 @@ void  LCD_Test()
             LCD_WriteCommand(0x80 | horizAddr);
             LCD_WriteData(HI_BYTE(pixelWord));
             LCD_WriteData(LO_BYTE(pixelWord));
+#ifdef LCD_USE_SHADOW_GDRAM
+            shadowGDRAM[row][col] = pixelWord;
+#endif
         }
         
         pixelWord = pixelWord >> 1;
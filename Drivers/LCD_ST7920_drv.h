@@ -1,7 +1,8 @@
 /*
  * File:    LCD_ST7920_drv.h
  *
- * Low-level driver def's for monochrome Graphic LCD module, 128 x 64 pixels.
+ * Low-level driver def's for monochrome Graphic LCD module, 128 x 64 pixels
+ * (or LCD_WIDTH x LCD_HEIGHT -- see LCD_buffer_def.h).
  *
  * Customized for LCD controller silicon:  ST7920.
  */
@@ -10,6 +11,22 @@
 
 #include "../system_def.h"
 #include "../Common/GenericTypeDefs.h"
+#include "LCD_buffer_def.h"          // screen buffer format
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+#error "ST7920 driver requires the default (row-major) screen buffer format!"
+#endif
+
+// ST7920 GDRAM is addressed as 32 rows x 16 words (256 pixels).  A panel up to 32 rows
+// high uses it directly;  on a 64-row panel, rows 32..63 are mapped to words 8..15.
+#if LCD_HEIGHT > 32 && LCD_WIDTH > 128
+#error "ST7920 driver supports panels up to 128 x 64 or 256 x 32 pixels!"
+#endif
+#define ST7920_COLS   ((LCD_WIDTH + 15) / 16)      // column-words (16 pixels) per row
+
+// Uncomment the next line to keep a copy of the ST7920 GDRAM in MCU RAM (1024 bytes).
+// LCD_WriteBlock() then sends only the words which differ from the GDRAM contents.
+//#define LCD_USE_SHADOW_GDRAM  1
 
 #define LCD_DATA_DIRN_IN()     (TRISE |= 0x00FF)
 #define LCD_DATA_DIRN_OUT()    (TRISE &= ~0x00FF)
@@ -37,7 +54,10 @@
 //
 bool    LCD_Init(void);
 void    LCD_ClearGDRAM();
-void    LCD_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+void    LCD_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+#ifdef LCD_ROTATION
+void    LCD_WriteStrip(scnword_t *strip, uint8 page);   // 1 page (LCD_WIDTH x 8 pixels)
+#endif
 void    LCD_Test();
 
 
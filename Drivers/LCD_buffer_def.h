@@ -0,0 +1,93 @@
+/*
+ * File:    LCD_buffer_def.h
+ *
+ * Screen buffer format def's shared by MJB's GLCD library (LCD_graphics_lib.c)
+ * and the low-level display controller drivers.
+ *
+ * The library and the driver must be compiled with the same buffer format and geometry
+ * options.
+ */
+#ifndef LCD_BUFFER_DEF_H
+#define LCD_BUFFER_DEF_H
+
+#include "../Common/system_def.h"
+
+// Panel size, pixels.  Define LCD_WIDTH and LCD_HEIGHT (e.g. in the compiler options) to
+// build the library and driver for a panel other than 128 x 64, e.g. 128 x 32, 132 x 64,
+// 96 x 16 or 256 x 64 (subject to the limits of the controller).  The height must be a
+// multiple of 8.  The screen buffer, and the loops which clear and flush it, are sized
+// for the panel at compile time.
+//
+#ifndef LCD_WIDTH
+#define LCD_WIDTH    128
+#endif
+#ifndef LCD_HEIGHT
+#define LCD_HEIGHT   64
+#endif
+#define LCD_PAGES    (LCD_HEIGHT / 8)      // number of pages (8 rows each)
+
+// Uncomment the next line to store the screen buffer in "page-major" format, the same
+// as SH1106 and KS0108 GDRAM:  8 pages x 128 bytes, each byte holding 8 pixels aligned
+// vertically (bit 0 at the top).  The driver then copies the buffer to GDRAM without
+// transformation.  This option is not supported by the ST7920 driver.
+//
+// Default format (row-major) is 64 rows x 8 column-words, each word holding 16 pixels
+// aligned horizontally (bit 15 at the LHS), the same as ST7920 GDRAM.
+// (Sizes given here are for a 128 x 64 panel.)
+//
+//#define LCD_BUFFER_PAGE_MAJOR  1
+
+// Uncomment the next line to store the (row-major) screen buffer as 64 rows x 4 column-
+// words of 32 pixels each, matching the native word size of 32-bit MCU's (e.g. PIC32).
+// Fill and image functions then process twice as many pixels per loop iteration.
+//
+//#define LCD_BUFFER_WORD32  1
+
+// Uncomment the next line to build the library in "page mode", without a screen buffer:
+// drawing calls on the screen are recorded in a display list, which is replayed for each
+// page (8 rows) into a strip buffer of 128 bytes, then streamed to the controller.
+// This saves 1KB of RAM at the cost of rendering time.  Page mode requires the page-major
+// buffer format (SH1106 and KS0108 only).
+//
+//#define LCD_PAGE_MODE  1
+
+// Uncomment the next line to support screen rotation (see LCD_SetRotation):  drawing is
+// done in logical (rotated) coordinates, and the screen buffer is rotated onto the panel
+// in blocks of 8 x 8 pixels as it is written to GDRAM, one page at a time.  Rotation
+// requires a panel width which is a multiple of 8, and is not available in page mode.
+//
+//#define LCD_ROTATION  1
+
+#if defined LCD_BUFFER_PAGE_MAJOR && defined LCD_BUFFER_WORD32
+#error "Screen buffer format options LCD_BUFFER_PAGE_MAJOR and LCD_BUFFER_WORD32 are exclusive!"
+#endif
+
+#if (LCD_HEIGHT % 8) != 0 || LCD_WIDTH < 8 || LCD_WIDTH > 256 || LCD_HEIGHT > 64
+#error "Panel height must be a multiple of 8 pixels, up to 64;  width 8..256 pixels!"
+#endif
+
+#if defined LCD_PAGE_MODE && !defined LCD_BUFFER_PAGE_MAJOR
+#error "Option LCD_PAGE_MODE requires screen buffer format LCD_BUFFER_PAGE_MAJOR!"
+#endif
+
+#if defined LCD_ROTATION && (defined LCD_PAGE_MODE || (LCD_WIDTH % 8) != 0)
+#error "Option LCD_ROTATION requires a panel width multiple of 8, and no LCD_PAGE_MODE!"
+#endif
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+typedef  uint8   scnword_t;     // 8 pixels, vertical, LS bit at top
+#elif defined LCD_BUFFER_WORD32
+typedef  uint32  scnword_t;     // 32 pixels, horizontal, MS bit at LHS
+#define  SCN_WORD_BITS   32
+#else
+typedef  uint16  scnword_t;     // 16 pixels, horizontal, MS bit at LHS
+#define  SCN_WORD_BITS   16
+#endif
+
+#ifndef LCD_BUFFER_PAGE_MAJOR
+#define  SCN_ROW_WORDS   ((LCD_WIDTH + SCN_WORD_BITS - 1) / SCN_WORD_BITS)   // words per row
+#define  SCN_WORD_MSB    ((scnword_t) 1 << (SCN_WORD_BITS - 1))   // LHS pixel in word
+#define  SCN_WORD_ONES   ((scnword_t) ~0)                         // all pixels in word
+#endif
+
+#endif  // LCD_BUFFER_DEF_H
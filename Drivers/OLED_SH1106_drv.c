@@ -10,9 +10,27 @@
  * 
  * Originated:  2021,  M.J.Bauer  [www.mjbauer.biz]
  */
+#include <string.h>
 #include "OLED_SH1106_drv.h"
 #include "I2C_drv.h"
 
+#ifdef LCD_USE_SHADOW_GDRAM
+// Copy of SH1106 GDRAM contents, visible segments only (ordered as [page][x])
+static  uint8  shadowGDRAM[LCD_PAGES][LCD_WIDTH];
+#endif
+
+// Panel orientation set by SH1106_SetFlip(), and the GDRAM column of the LHS pixel
+static  bool   flipHoriz;
+static  bool   flipVert;
+static  uint8  columnOffset = SH1106_COLUMN_OFFSET;
+static  bool   initDone;   // True once SH1106_Init() has configured the controller
+
+PRIVATE  void  SH1106_WritePageSpan(uint8 page, int firstCol, uint8 *pSeg, int count);
+PRIVATE  void  SH1106_WriteSegments(uint8 x, uint8 *data, int count);
+#ifndef LCD_BUFFER_PAGE_MAJOR
+PRIVATE  void  SH1106_TransposePage(scnword_t *pRows, int firstCol, int lastCol, uint8 *segData);
+#endif
+
 //  Wrappers for driver functions called from LCD_graphics_lib.c
 //
 void  LCD_Init()
@@ -25,11 +43,18 @@ void  LCD_ClearGDRAM()
     SH1106_ClearGDRAM();
 }
 
-void  LCD_WriteBlock(uint16 *scnbuf, uint16 x, uint16 y, uint16 w, uint16 h)
+void  LCD_WriteBlock(scnword_t *scnbuf, uint16 x, uint16 y, uint16 w, uint16 h)
 {
     SH1106_WriteBlock(scnbuf, x, y, w, h);
 }
 
+#if defined LCD_BUFFER_PAGE_MAJOR || defined LCD_ROTATION
+void  LCD_WriteStrip(scnword_t *strip, uint8 page)
+{
+    SH1106_WriteStrip(strip, page);
+}
+#endif
+
 
 /*----------------------------------------------------------------------------------
  * Name               :  SH1106_WriteCommand()
@@ -78,7 +103,7 @@ void  SH1106_Init(void)
     SH1106_WriteCommand(SH1106_SETDISPLAYCLOCKDIV);            // 0xD5
     SH1106_WriteCommand(0x80);                                 // (suggested)
     SH1106_WriteCommand(SH1106_SETMULTIPLEX);                  // 0xA8
-    SH1106_WriteCommand(0x3F);
+    SH1106_WriteCommand(LCD_HEIGHT - 1);                       // 0x3F for 64 rows
     SH1106_WriteCommand(SH1106_SETDISPLAYOFFSET);              // 0xD3
     SH1106_WriteCommand(0x00);                                 // no offset
 
@@ -87,11 +112,11 @@ void  SH1106_Init(void)
     SH1106_WriteCommand(0x10);
     SH1106_WriteCommand(SH1106_MEMORYMODE);                    // 0x20
     SH1106_WriteCommand(0x00);                                 // use KS0108 format
-    SH1106_WriteCommand(SH1106_SEGREMAP | 1);                  // 0xA0
-    SH1106_WriteCommand(SH1106_COMSCANDEC);
+    SH1106_WriteCommand(SH1106_SEGREMAP | (flipHoriz ? 0 : 1));   // 0xA1 (see SetFlip)
+    SH1106_WriteCommand(flipVert ? SH1106_COMSCANINC : SH1106_COMSCANDEC);
     
     SH1106_WriteCommand(SH1106_SETCOMPINS);                    // 0xDA
-    SH1106_WriteCommand(0x12);
+    SH1106_WriteCommand(SH1106_COMPINS);
     SH1106_WriteCommand(SH1106_SETCONTRAST);                   // 0x81
     SH1106_WriteCommand(0x3F);                                 // POR value = 0x80
     SH1106_WriteCommand(SH1106_SETPRECHARGE);                  // 0xD9
@@ -102,6 +127,7 @@ void  SH1106_Init(void)
     SH1106_WriteCommand(SH1106_DISPLAYALLON_RESUME);           // 0xA4
     SH1106_WriteCommand(SH1106_NORMALDISPLAY);                 // 0xA6
     SH1106_WriteCommand(SH1106_DISPLAYON);                     // 0xAF
+    initDone = TRUE;
 }
 
 
@@ -131,6 +157,52 @@ void  SH1106_Sleep(void)
 }
 
 
+/*----------------------------------------------------------------------------------
+ * Name               :  SH1106_SetFlip()
+ *
+ * Function           :  Mirror the panel horizontally and/or vertically, by reversing the
+ *                       segment (column) or common (row) scan order in the controller,
+ *                       e.g. for a module mounted upside down (both flipped).  The image
+ *                       is flipped by the controller at no cost in CPU time;  the screen
+ *                       buffer and GDRAM layout are unchanged.
+ *                       Reversing the segments moves the visible window to the other end
+ *                       of the 132 GDRAM columns, so the column offset is adjusted.  If
+ *                       the panel is not centred (see SH1106_COLUMN_OFFSET), the GDRAM
+ *                       contents would then be misplaced, so GDRAM (and the shadow copy,
+ *                       if used) is cleared;  redraw the screen after the call.
+ *                       May be called before SH1106_Init();  the setting is then only
+ *                       stored (nothing is sent to the controller) and Init applies it.
+ *
+ * Input              :  horiz = TRUE to mirror left-to-right (segment remap)
+ *                       vert = TRUE to mirror top-to-bottom (COM scan direction)
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  SH1106_SetFlip(bool horiz, bool vert)
+{
+    uint8  offset = SH1106_COLUMN_OFFSET;
+
+    if (horiz)  offset = SH1106_NUMBEROF_SEGMENTS - LCD_WIDTH - SH1106_COLUMN_OFFSET;
+
+    flipHoriz = horiz;
+    flipVert = vert;
+
+    if (!initDone)   // controller not set up yet -- SH1106_Init() applies the flip
+    {
+        columnOffset = offset;
+        return;
+    }
+
+    SH1106_WriteCommand(SH1106_SEGREMAP | (horiz ? 0 : 1));
+    SH1106_WriteCommand(vert ? SH1106_COMSCANINC : SH1106_COMSCANDEC);
+
+    if (offset != columnOffset)   // visible window moved -- GDRAM (and shadow) now stale
+    {
+        columnOffset = offset;
+        SH1106_ClearGDRAM();
+    }
+}
+
+
 /*----------------------------------------------------------------------------------
  * Name               :  SH1106_SetContrast()
  * Function           :  Set OLED display contrast (brightness).
@@ -166,33 +238,43 @@ void  SH1106_SetContrast(unsigned level_pc)
  * Legend: Page = 8 lines.  Data byte (|) = 8 pixels vertical, bit 0 is at the top.
  * 
  * NB: The first 2 pixels on each line (segments 0 and 1) are not displayed.
+ *     (On a 128 x 64 panel -- see SH1106_COLUMN_OFFSET.)  Only the pages shown on
+ *     the panel (LCD_PAGES) are cleared.  The page and column address are sent once
+ *     per page, in one command stream;  the data is sent in transactions of up to
+ *     SH1106_MAXSEGMENTSPERWRITE bytes, as in SH1106_WriteSegments().
 ------------------------------------------------------------------------------------*/
 void  SH1106_ClearGDRAM(void)
 {
-    int   page, partition, segment;  // 16 segments per partition
+    int   page, segment, i;
 
-    for (page = 0;  page < 8;  page++)
+    for (page = 0;  page < LCD_PAGES;  page++)
     {
-        // Set GDRAM start of page address -- there are 8 pages
-        SH1106_WriteCommand(SH1106_PAGEADDR + page);
+        // Set GDRAM page address and column 0 in a single command stream
+        if (!I2C1MasterStart(SH1106_I2C_ADDRESS))  continue;
+        I2C1MasterSend(SH1106_MESSAGETYPE_COMMANDSTREAM);
+        I2C1MasterSend(SH1106_PAGEADDR + page);
+        I2C1MasterSend(SH1106_SETCOLUMNADDRLOW);   // AddrLow = 0
+        I2C1MasterSend(SH1106_SETCOLUMNADDRHIGH);  // AddrHigh = 0
+        Stop_I2C1();
 
-        for (partition = 0;  partition < 9;  partition++)  
+        // Write all 132 segments of the page in auto-increment mode, 16 (max.) at a time
+        for (segment = 0;  segment < SH1106_NUMBEROF_SEGMENTS;  segment += i)
         {
-            // Set column/segment address for this partition
-            SH1106_WriteCommand(SH1106_SETCOLUMNADDRLOW);  // AddrLow = 0
-            SH1106_WriteCommand(SH1106_SETCOLUMNADDRHIGH + partition);
-            // write 16 segments (max.) in auto-increment mode
-            I2C1MasterStart(SH1106_I2C_ADDRESS);
+            if (!I2C1MasterStart(SH1106_I2C_ADDRESS))  break;
             I2C1MasterSend(SH1106_MESSAGETYPE_DATA);
 
-            for (segment = 0;  segment < 16;  segment++)
+            for (i = 0;  i < SH1106_MAXSEGMENTSPERWRITE
+                         && (segment + i) < SH1106_NUMBEROF_SEGMENTS;  i++)
             {
-//              if (partition == 8 && segment > 3) break;  // done 132 segments
                 I2C1MasterSend(0);
             }
             Stop_I2C1();
         }
     }
+
+#ifdef LCD_USE_SHADOW_GDRAM
+    memset(shadowGDRAM, 0, sizeof(shadowGDRAM));
+#endif
 }
 
 
@@ -214,29 +296,28 @@ void  SH1106_ClearGDRAM(void)
  * Notes:     :  The (external) screen buffer is formatted as 8 "columns" horizonally
  *               by 64 "rows" vertically. Each column has 16 pixels. The leftmost
  *               pixel is stored in the MS bit (bit15) of the column.
+ *               If LCD_BUFFER_PAGE_MAJOR is defined, the buffer is in GDRAM format,
+ *               8 pages x 128 bytes, and is copied without transformation.
  *               For details, see MJB's LCD graphics library (LCD_graphics_lib.c).
 ------------------------------------------------------------------------------------*/
-void  SH1106_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
+void  SH1106_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
 {
     uint8   page;                   // page address in SH1106 (1 page = 8 rows)
-    uint8   x_coord;                // pixel horizontal coordinate
-    int     row, col;               // row and column word index for screen buffer
     int     firstPage;              // first (top) page to be modified
     int     lastPage;               // last (bottom) page to be modified
     int     firstCol;               // first (leftmost) column in a row to be modified
     int     lastCol;                // last (rightmost) column in a row to be modified
-    int     offset;                 // address offset of pixel word in scnBuf
-    uint8   segAddr;                // segment address for write
-    uint8   pixels;                 // 8 pixels aligned vertically (LS bit at top)
-    uint8   bitmask;
-    uint16  pixelWord[8];           // 8 rows x 16 pixels in a "column" to be modified
-    uint16  *pBuf;
+    uint8   *pSeg;                  // data for 1 page, cols firstCol..lastCol
+    int     count;                  // number of bytes in page span
+#ifndef LCD_BUFFER_PAGE_MAJOR
+    uint8   segData[(LCD_WIDTH + 15) & ~15];   // transposed pixels for 1 page
+#endif
 
-    if (y > 63)  y = 0;             // prevent writing past end-of-screen (vert.)
-    if ((y + h) > 63)  h = 63 - y;
+    if (y >= LCD_HEIGHT)  y = 0;    // prevent writing past end-of-screen (vert.)
+    if ((y + h) > LCD_HEIGHT)  h = LCD_HEIGHT - y;
 
-    if (x > 127)  x = 0;            // prevent writing past end-of-row (horiz.)
-    if ((x + w) > 128)  w = 128 - x;
+    if (x >= LCD_WIDTH)  x = 0;     // prevent writing past end-of-row (horiz.)
+    if ((x + w) > LCD_WIDTH)  w = LCD_WIDTH - x;
 
     firstPage = y / 8;
     lastPage = (y + h - 1) / 8;
@@ -246,44 +327,193 @@ void  SH1106_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
 
     for (page = firstPage;  page <= lastPage;  page++)
     {
-        SH1106_WriteCommand(SH1106_PAGEADDR | page);   // set page address (0..7)
-        
-        for (col = firstCol;  col <= lastCol && col < 8;  col++)
+        count = (lastCol - firstCol + 1) * 16;
+        if ((firstCol * 16 + count) > LCD_WIDTH)  count = LCD_WIDTH - firstCol * 16;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+        pSeg = scnBuf + page * LCD_WIDTH + firstCol * 16;   // buffer is in GDRAM format
+#else
+        pSeg = segData;
+        SH1106_TransposePage(scnBuf + page * 8 * SCN_ROW_WORDS, firstCol, lastCol, segData);
+#endif
+        SH1106_WritePageSpan(page, firstCol, pSeg, count);
+    }
+}
+
+
+#if defined LCD_BUFFER_PAGE_MAJOR || defined LCD_ROTATION
+/*----------------------------------------------------------------------------------
+ * Function   :  SH1106_WriteStrip()
+ *
+ * Overview   :  Copies one page of pixels (LCD_WIDTH x 8), rendered in a strip buffer
+ *               in screen buffer format, to the SH1106 GDRAM.  Used in page mode
+ *               (LCD_PAGE_MODE), where the graphics library has no full screen buffer,
+ *               and to write the screen in rotated orientation (LCD_ROTATION).
+ *
+ * Input      :  strip = address of LCD_WIDTH bytes (8 pixels vertical each, bit 0 at top)
+ *                       or, if row-major, 8 rows of SCN_ROW_WORDS words
+ *               page = page address (0..LCD_PAGES-1)
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+void  SH1106_WriteStrip(scnword_t *strip, uint8 page)
+{
+#ifndef LCD_BUFFER_PAGE_MAJOR
+    uint8   segData[(LCD_WIDTH + 15) & ~15];   // transposed pixels for 1 page
+#endif
+
+    if (page >= LCD_PAGES)  return;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    SH1106_WritePageSpan(page, 0, strip, LCD_WIDTH);
+#else
+    SH1106_TransposePage(strip, 0, (LCD_WIDTH - 1) / 16, segData);
+    SH1106_WritePageSpan(page, 0, segData, LCD_WIDTH);
+#endif
+}
+#endif
+
+
+#ifndef LCD_BUFFER_PAGE_MAJOR
+/*----------------------------------------------------------------------------------
+ * Function   :  SH1106_TransposePage()
+ *
+ * Overview   :  Transposes the pixels in one page (8 rows) of a row-major screen
+ *               buffer, columns firstCol..lastCol (16 pixels each), to GDRAM format,
+ *               i.e. one byte per segment, 8 pixels vertical, bit 0 at the top.
+ *
+ * Input      :  pRows = address of the first row of the page in the buffer
+ *               firstCol, lastCol = first and last column (16 pixels) to transpose
+ * Output     :  segData = 16 bytes per column, leftmost segment first
+------------------------------------------------------------------------------------*/
+PRIVATE  void  SH1106_TransposePage(scnword_t *pRows, int firstCol, int lastCol, uint8 *segData)
+{
+    int     col;                    // column index (16 pixels) in screen buffer
+    int     row;                    // row index in page
+    uint8   x_coord;                // pixel horizontal coordinate
+    uint8   pixels;                 // 8 pixels aligned vertically (LS bit at top)
+    uint8   bitmask;
+    uint16  pixelWord[8];           // 8 rows x 16 pixels in a "column" to be modified
+    scnword_t  *pBuf;
+    int     shift;                  // bits to shift buffer word to get 16 pixels
+    uint8   *pSeg = segData;
+
+    for (col = firstCol;  col <= lastCol;  col++)
+    {
+        // Grab a bunch of 16 (H) x 8 (V) pixels from buffer...
+        shift = SCN_WORD_BITS - 16 - (col * 16) % SCN_WORD_BITS;  // 16 or 0 if 32-bit
+        pBuf = pRows + (col * 16) / SCN_WORD_BITS;
+        for (row = 0;  row < 8;  row++)  // 8 rows in SH1106 page
         {
-            // Grab a bunch of 16 (H) x 8 (V) pixels from buffer...
-            offset = page * 64 + col;  // 64 words per buffer "page"
-            pBuf = scnBuf + offset;
-            for (row = 0;  row < 8;  row++)  // 8 rows in SH1106 page
-            {
-                pixelWord[row] = *pBuf;
-                pBuf += 8;  // next row (advance 8 col's)
-            }
+            pixelWord[row] = (uint16) (*pBuf >> shift);
+            pBuf += SCN_ROW_WORDS;  // next row
+        }
 
-            segAddr = col * 16 + 2;   // the first 2 pixels on any line are duds!
-            SH1106_WriteCommand(SH1106_SETCOLUMNADDRLOW + (segAddr & 0xF)); 
-            SH1106_WriteCommand(SH1106_SETCOLUMNADDRHIGH + (segAddr >> 4)); 
-            // Write bunch of pixels, 16 (H) x 8 (V) to SH1106 controller
-            I2C1MasterStart(SH1106_I2C_ADDRESS);
-            I2C1MasterSend(SH1106_MESSAGETYPE_DATA);
-            
-            for (x_coord = 0;  x_coord < 16;  x_coord++)
+        for (x_coord = 0;  x_coord < 16;  x_coord++)
+        {
+            // transpose horiz pixels in pixelWord[8] to vertical pixelByte
+            pixels = 0;
+            bitmask = 0x01;
+            for (row = 0;  row < 8;  row++)
             {
-                // transpose horiz pixels in pixelWord[8] to vertical pixelByte
-                pixels = 0;
-                bitmask = 0x01;
-                for (row = 0;  row < 8;  row++)
-                {
-                    if (pixelWord[row] & 0x8000) pixels |= bitmask;
-                    bitmask = bitmask << 1;   // next pixel down
-                    pixelWord[row] = pixelWord[row] << 1;  // next pixel right
-                }
-                // write 8 pixels (vertical) to SH1106 controller
-                I2C1MasterSend(pixels);  // segment address auto increments
+                if (pixelWord[row] & 0x8000) pixels |= bitmask;
+                bitmask = bitmask << 1;   // next pixel down
+                pixelWord[row] = pixelWord[row] << 1;  // next pixel right
             }
-            Stop_I2C1();
+            *pSeg++ = pixels;   // 8 pixels (vertical) for segment
         }
     }
 }
+#endif
+
+
+/*----------------------------------------------------------------------------------
+ * Function   :  SH1106_WritePageSpan()
+ *
+ * Overview   :  Writes a span of segments, in whole columns of 16 pixels, to one page
+ *               of SH1106 GDRAM.  If LCD_USE_SHADOW_GDRAM is defined, only the runs
+ *               of segments which differ from the GDRAM contents are written.
+ *               The last column is partial if the span ends at the right edge of a
+ *               panel whose width is not a multiple of 16.
+ *
+ * Input      :  page = page address (0..7),  firstCol = first column (0..7)
+ *               pSeg = pointer to segment data,  count = number of bytes (16 x cols)
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+PRIVATE  void  SH1106_WritePageSpan(uint8 page, int firstCol, uint8 *pSeg, int count)
+{
+#ifdef LCD_USE_SHADOW_GDRAM
+    int     i, first, last;         // index of first and last bytes in a run of changes
+    uint8   *pShadow;
+#else
+    int     col;                    // column index (16 pixels) in span
+    int     n;                      // number of bytes in column
+#endif
+
+    SH1106_WriteCommand(SH1106_PAGEADDR | page);   // set page address (0..7)
+
+#ifdef LCD_USE_SHADOW_GDRAM
+    // Write only the runs of segments which differ from the GDRAM (shadow) contents.
+    // Unchanged gaps shorter than the cost of re-addressing are sent with the run.
+    pShadow = &shadowGDRAM[page][firstCol * 16];
+
+    for (i = 0;  i < count;  )
+    {
+        if (pSeg[i] == pShadow[i])  { i++;  continue; }
+
+        first = last = i;
+        for (i++;  i < count && (i - last) <= SH1106_SHADOW_MAX_GAP;  i++)
+        {
+            if (pSeg[i] != pShadow[i])  last = i;
+        }
+
+        SH1106_WriteSegments(firstCol * 16 + first, &pSeg[first], last - first + 1);
+        memcpy(&pShadow[first], &pSeg[first], last - first + 1);
+        i = last + 1;
+    }
+#else
+    // Write bunches of pixels, 16 (H) x 8 (V), to SH1106 controller
+    for (col = firstCol;  (col - firstCol) * 16 < count;  col++)
+    {
+        n = count - (col - firstCol) * 16;
+        SH1106_WriteSegments(col * 16, &pSeg[(col - firstCol) * 16], (n < 16) ? n : 16);
+    }
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Function   :  SH1106_WriteSegments()
+ *
+ * Overview   :  Writes a sequence of data bytes (8 vertical pixels each) to the
+ *               current page of SH1106 GDRAM, starting at visible column x.
+ *               Data is sent in transactions of up to SH1106_MAXSEGMENTSPERWRITE bytes.
+ *
+ * Input      :  x = pixel horizontal coordinate (0..LCD_WIDTH-1)
+ *               data = pointer to data bytes,  count = number of bytes to write
+ *
+ * Return     :  --
+------------------------------------------------------------------------------------*/
+PRIVATE  void  SH1106_WriteSegments(uint8 x, uint8 *data, int count)
+{
+    uint8   segAddr = x + columnOffset;   // e.g. first 2 segments are duds!
+    int     i;
+
+    SH1106_WriteCommand(SH1106_SETCOLUMNADDRLOW + (segAddr & 0xF)); 
+    SH1106_WriteCommand(SH1106_SETCOLUMNADDRHIGH + (segAddr >> 4)); 
+
+    while (count > 0)
+    {
+        I2C1MasterStart(SH1106_I2C_ADDRESS);
+        I2C1MasterSend(SH1106_MESSAGETYPE_DATA);
+
+        for (i = 0;  i < SH1106_MAXSEGMENTSPERWRITE && i < count;  i++)
+        {
+            I2C1MasterSend(*data++);  // segment address auto increments
+        }
+        Stop_I2C1();
+        count -= i;
+    }
+}
 
 
 /*----------------------------------------------------------------------------------
@@ -293,7 +523,7 @@ void  SH1106_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h)
  *                       The MCU RAM buffer is bypassed, i.e. not used.
  *                       The screen should show a pattern of diagonal lines,
  *                       slope -45 degrees, thickness 1 pixel, spaced 8 pixels apart,
- *                       within an area 128 x 64 pixels.
+ *                       within an area LCD_WIDTH x LCD_HEIGHT pixels (128 x 64).
  * Input              :  --
  * Note               :  May be called without first calling SH1106_ClearGDRAM(),
  *                       but then random pixels may appear in segments 130, 131.
@@ -304,15 +534,15 @@ void  SH1106_Test_Pattern()
     uint8  segAddr;
     uint8  pixels;
 
-    for (page = 0;  page < 8;  page++)
+    for (page = 0;  page < LCD_PAGES;  page++)
     {
         // Set GDRAM start of page address -- there are 8 pages
         SH1106_WriteCommand(SH1106_PAGEADDR + page);
 
-        for (column = 0;  column < 16;  column++)   // 16 "columns" of 8 pix
+        for (column = 0;  column < LCD_WIDTH / 8;  column++)   // 16 "columns" of 8 pix
         {
             // Set segment address for this column
-            segAddr = column * 8 + 2;
+            segAddr = column * 8 + columnOffset;
             SH1106_WriteCommand(SH1106_SETCOLUMNADDRLOW + (segAddr & 0xF)); 
             SH1106_WriteCommand(SH1106_SETCOLUMNADDRHIGH + (segAddr >> 4));
             
@@ -324,6 +554,9 @@ void  SH1106_Test_Pattern()
             for (line = 0;  line < 8;  line++)  // 8 lines x 8 pix
             {
                 I2C1MasterSend(pixels);
+#ifdef LCD_USE_SHADOW_GDRAM
+                shadowGDRAM[page][column * 8 + line] = pixels;
+#endif
                 pixels = pixels << 1;   // move 1 pixel down
             }
             Stop_I2C1();
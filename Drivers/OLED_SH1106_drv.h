@@ -8,6 +8,7 @@
 #define SH1106_OLED_DRV_H
 
 #include "../Common/system_def.h"   // MJB's typedefs, etc
+#include "LCD_buffer_def.h"          // screen buffer format
 
 // Temporary def for compilation of driver alone; normally defined in app. program.
 // #define USE_I2C_CHANNEL_1  
@@ -19,6 +20,28 @@
 #define SH1106_I2C_ADDRESS  (0x3D<<1)  // (pin SA0 = High)
 */
 
+// Uncomment the next line to keep a copy of the SH1106 GDRAM in MCU RAM (1024 bytes).
+// SH1106_WriteBlock() then sends only the bytes which differ from the GDRAM contents.
+//#define LCD_USE_SHADOW_GDRAM  1
+
+// Unchanged bytes between two changed runs are re-sent if the gap is no longer than this;
+// starting a new run costs 3 IIC transactions (column address and data) = 8 bytes.
+#define SH1106_SHADOW_MAX_GAP   8
+
+// The SH1106 drives 132 segments x 64 commons;  panels narrower than 132 pixels are
+// wired to the middle segments (e.g. 2..129 for 128 pixels), panels less than 64 rows
+// high to the first commons.  Override these if the module is wired otherwise.
+// (The column offset applies in the default orientation -- see SH1106_SetFlip.)
+#if LCD_WIDTH > 132
+#error "SH1106 driver supports panels up to 132 pixels wide!"
+#endif
+#ifndef SH1106_COLUMN_OFFSET
+#define SH1106_COLUMN_OFFSET   ((132 - LCD_WIDTH) / 2)   // first visible segment
+#endif
+#ifndef SH1106_COMPINS
+#define SH1106_COMPINS   ((LCD_HEIGHT > 32) ? 0x12 : 0x02)   // COM pins h/w configuration
+#endif
+
 //-------------- SH1106 Command Bytes ------------------
 //
 #define SH1106_SETCONTRAST 0x81
@@ -48,6 +71,7 @@
 #define SH1106_SWITCHCAPVCC 0x02
 
 #define SH1106_MESSAGETYPE_COMMAND 0x80
+#define SH1106_MESSAGETYPE_COMMANDSTREAM 0x00   // Co = 0:  all following bytes are commands
 #define SH1106_MESSAGETYPE_DATA 0x40
 #define SH1106_READMODIFYWRITE_START 0xE0
 #define SH1106_READMODIFYWRITE_END 0xEE
@@ -57,11 +81,12 @@
 #define SH1106_NUMBEROF_PAGES 8
 
 // OLED screen size
-#define SH1106_WIDTH_PIXELS   128
-#define SH1106_HEIGHT_PIXELS  64
+#define SH1106_WIDTH_PIXELS   LCD_WIDTH
+#define SH1106_HEIGHT_PIXELS  LCD_HEIGHT
 
 #define OLED_Display_Wake()    SH1106_WriteCommand(SH1106_DISPLAYON)
 #define OLED_Display_Sleep()   SH1106_WriteCommand(SH1106_DISPLAYOFF); 
+#define OLED_Display_Flip(h, v)  SH1106_SetFlip(h, v)   // Mirror panel (both: 180 deg)
 
 
 //  SH1106 OLED controller low-level functions defined in the driver module
@@ -72,8 +97,12 @@ void  SH1106_Init();
 void  SH1106_Wake();
 void  SH1106_Sleep();
 void  SH1106_SetContrast(unsigned level_pc);  // %
+void  SH1106_SetFlip(bool horiz, bool vert);   // Mirror panel by h/w scan direction
 void  SH1106_ClearGDRAM();
-void  SH1106_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+void  SH1106_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+#if defined LCD_BUFFER_PAGE_MAJOR || defined LCD_ROTATION
+void  SH1106_WriteStrip(scnword_t *strip, uint8 page);   // 1 page (LCD_WIDTH x 8 pixels)
+#endif
 void  SH1106_Test_Pattern();
 
 #endif  // SH1106_OLED_DRV_H
@@ -1,7 +1,8 @@
 /*
  * File:          LCD_graphics_lib.c
  *
- * Overview:      API Library functions for Monochrome Graphic LCD module, 128 x 64 pixels.
+ * Overview:      API Library functions for Monochrome Graphic LCD module, 128 x 64 pixels
+ *                (or LCD_WIDTH x LCD_HEIGHT, if defined).
  *
  * Dependencies:  This module links with a low-level driver module supporting the LCD controller 
  *                chip-set, which may be "LCD_KS0108_drv.c" (for KS0107/KS0108 chipset) 
@@ -9,8 +10,38 @@
  *
  * Originated:    2015 M.J. Bauer,  Revised: 2018   [www.mjbauer.biz]
  */
+#include <string.h>
 #include "LCD_graphics_lib.h"
 
+// Kernel worker functions are always expanded in line.  Each is called with a constant
+// writing mode, so the compiler generates a separate loop for each mode, with the mode
+// test (and the collision test, if not wanted) removed from the loop.
+#define INLINE  static inline __attribute__((always_inline))
+
+// Writing mode used only within the library:  the image kernels test for collision,
+// without modifying the buffer (see LCD_TestImage).
+#define TEST_PIXELS   5
+
+// Whole-buffer kernels process pixels a machine word at a time (SWAR):  32 bits on PIC32,
+// 64 bits in a host build.  Buffers are accessed through this type as well as scnword_t.
+#if defined __SIZEOF_POINTER__ && __SIZEOF_POINTER__ == 8
+typedef  uint64  lcdword_t  __attribute__((may_alias));
+#else
+typedef  uint32  lcdword_t  __attribute__((may_alias));
+#endif
+
+#ifdef LCD_PAGE_MODE
+// Drawing state in effect at a point in the screen list, tracked by LCD_CompactList()
+typedef  struct
+{
+    uint8   mode;                   // pixel mode;  0xFF if not known
+    uint8   font;                   // font ID;  0xFF if not known
+    uint8   clip[9];                // last clip record (DL_CLIP or DL_RESETCLIP), or 0
+    int     clipLeft, clipTop;      // clip rectangle on screen (right, bottom exclusive)
+    int     clipRight, clipBottom;
+} liststate_t;
+#endif
+
 // The following functions are not directly accessible to the application
 PRIVATE  void   LCD_PutChar8(uint8 uc);
 PRIVATE  void   LCD_PutChar16(uint8 uc);
@@ -18,6 +49,86 @@ PRIVATE  void   LCD_PutChar16_ruff(uint8 uc);
 PRIVATE  void   LCD_PutChar16_smooth(uint8 uc);
 PRIVATE  void   LCD_PutChar12(uint8 uc);
 PRIVATE  void   LCD_PutChar24(uint8 uc);
+PRIVATE  void   LCD_UpdateBlock(int x, int y, int w, int h);
+PRIVATE  bool   LCD_ClipBlock(int *x, int *y, int *w, int *h, int *sx, int *sy);
+PRIVATE  void   LCD_SetClipRect(int x, int y, int w, int h);
+PRIVATE  void   LCD_DrawChar(uint8 uc);
+PRIVATE  int16  LCD_ShowText(char *str, int count);
+PRIVATE  displist_t  *LCD_GetRecorder(bool anyTarget);
+PRIVATE  bool   LCD_ListBegin(displist_t *list, uint8 opcode, int size);
+PRIVATE  void   LCD_ListPut16(displist_t *list, int value);
+PRIVATE  void   LCD_ListPutPtr(displist_t *list, const void *ptr);
+PRIVATE  int    LCD_ListGet16(uint8 **ppData);
+PRIVATE  void  *LCD_ListGetPtr(uint8 **ppData);
+PRIVATE  void   LCD_RecordSetting(uint8 opcode, int value);
+PRIVATE  void   LCD_RecordBlock(uint8 opcode, int w, int h, const void *data1, const void *data2);
+PRIVATE  void   LCD_RecordText(char *str, int count);
+PRIVATE  void   LCD_ReplayList(uint8 *data, int length, int dx, int dy);
+#ifdef LCD_PAGE_MODE
+PRIVATE  void   LCD_RecordState(void);
+PRIVATE  void   LCD_RenderPage(int page);
+PRIVATE  void   LCD_CompactList(displist_t *list);
+PRIVATE  int    LCD_ListRecordSize(uint8 *pData);
+PRIVATE  bool   LCD_ListTrack(liststate_t *state, uint8 *pData);
+PRIVATE  bool   LCD_ListArea(liststate_t *state, uint8 *pData, int *area);
+PRIVATE  bool   LCD_ListCovered(liststate_t *state, uint8 *pData, uint8 *pEnd, int *area);
+PRIVATE  uint8 *LCD_ListEmitState(liststate_t *state, liststate_t *emitted, uint8 *pOut);
+#endif
+#ifdef LCD_ROTATION
+PRIVATE  void   LCD_RotateBlock(int *x, int *y, int *w, int *h);
+PRIVATE  void   LCD_RenderRotatedPage(int page);
+INLINE   uint64 LCD_GetBlock8x8(scnword_t *bits, int stride, int x, int y);
+INLINE   void   LCD_PutBlock8x8(scnword_t *bits, int stride, int x, uint64 block);
+INLINE   uint64 LCD_FlipDiagonal8x8(uint64 block);
+INLINE   uint64 LCD_FlipRows8x8(uint64 block);
+INLINE   uint64 LCD_FlipCols8x8(uint64 block);
+#endif
+#ifndef LCD_BUFFER_PAGE_MAJOR
+PRIVATE  void   LCD_FillRows(surface_t *dst, int x, int y, int w, int h);
+PRIVATE  uint8  LCD_PutImageRows(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                 int x, int y, int w, int h, int bytesInRow, int sx,
+                                 collision_t *info);
+PRIVATE  void   LCD_BlitSurfaceRows(surface_t *dst, surface_t *src, int sx, int sy,
+                                    int x, int y, int w, int h);
+INLINE   void   LCD_FillRowsOp(surface_t *dst, int x, int y, int w, int h, uint8 mode);
+INLINE   uint8  LCD_PutImageRowsOp(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                   int x, int y, int w, int h, int bytesInRow, int sx,
+                                   uint8 mode, bool checkCollision, collision_t *info);
+INLINE   void   LCD_BlitSurfaceRowsOp(surface_t *dst, surface_t *src, int sx, int sy,
+                                      int x, int y, int w, int h, uint8 mode);
+PRIVATE  void   LCD_ScrollRows(surface_t *dst, int x, int y, int w, int h, int dx, int dy);
+PRIVATE  int    LCD_CountRows(surface_t *src, int x, int y, int w, int h);
+INLINE   scnword_t  LCD_GetImageWord(uint8 *rowData, int byteIndex, int bytesInRow);
+INLINE   scnword_t  LCD_GetSurfaceWord(scnword_t *rowData, int bitIndex, int wordsInRow);
+#else
+PRIVATE  void   LCD_FillPages(surface_t *dst, int x, int y, int w, int h);
+PRIVATE  uint8  LCD_PutImagePages(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                  int x, int y, int w, int h, int bytesInRow, int sx,
+                                  collision_t *info);
+PRIVATE  void   LCD_BlitSurfacePages(surface_t *dst, surface_t *src, int sx, int sy,
+                                     int x, int y, int w, int h);
+INLINE   uint8  LCD_PutImagePagesOp(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                    int x, int y, int w, int h, int bytesInRow, int sx,
+                                    uint8 mode, bool checkCollision, collision_t *info);
+INLINE   void   LCD_BlitSurfacePagesOp(surface_t *dst, surface_t *src, int sx, int sy,
+                                       int x, int y, int w, int h, uint8 mode);
+PRIVATE  void   LCD_ScrollPages(surface_t *dst, int x, int y, int w, int h, int dx, int dy);
+PRIVATE  int    LCD_CountPages(surface_t *src, int x, int y, int w, int h);
+PRIVATE  void   LCD_Transpose8x8(uint8 *rowBytes, uint8 *colBytes);
+#endif
+PRIVATE  uint8  LCD_BlitImage(bitmap_t *imageData, bitmap_t *maskData, uint16 w, uint16 h,
+                              bool checkCollision);
+PRIVATE  void   LCD_FillTarget(uint8 mode);
+PRIVATE  void   LCD_DrawLineRuns(surface_t *dst, int x0, int y0, int x1, int y1,
+                                 int left, int top, int w, int h);
+INLINE   void   LCD_FillRun(surface_t *dst, int x, int y, int w, int h);
+PRIVATE  void   LCD_FillBytes(uint8 *pData, int count, uint8 mode);
+PRIVATE  int    LCD_CountBytes(uint8 *pData, int count);
+INLINE   int    LCD_CountBits(lcdword_t bits);
+PRIVATE  bool   LCD_CompareBytes(uint8 *pData1, uint8 *pData2, int count);
+PRIVATE  void   LCD_ClearPadding(surface_t *surface);
+INLINE   void   LCD_AddCollision(collision_t *info, int left, int top, int right, int bottom,
+                                 int count);
 
 
 /*`````````````````````````````````````````````````````````````````````````````````````````````````
@@ -412,14 +523,59 @@ const  uint8  font_table_prop_7x12[] =
 
 
 // Private data...
-static  uint16 screenBuffer[64][8];     // 64 rows x 8 cols x 16 pixels
+// Driver for the default display context -- the controller module linked with the library
+static  const lcddriver_t  DefaultDriver =
+{
+    .clearGDRAM = LCD_ClearGDRAM,
+    .writeBlock = LCD_WriteBlock,
+#if defined LCD_PAGE_MODE || defined LCD_ROTATION
+    .writeStrip = LCD_WriteStrip,
+#endif
+};
+
+// Default display context, selected until LCD_SelectContext() is called.  This is the
+// state the library kept in file-scope variables, so existing applications need no change.
+static  lcdcontext_t  DefaultContext =
+{
+    .driver = &DefaultDriver,
+#ifdef LCD_PAGE_MODE
+    .strip = { LCD_WIDTH, 8, LCD_WIDTH, DefaultContext.stripBuffer },
+    .screenList = { DefaultContext.screenListData, LCD_DISPLAY_LIST_SIZE, 0, FALSE },
+    .screen = { LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH, NULL },   // no buffer -- calls recorded
+#elif defined LCD_BUFFER_PAGE_MAJOR
+    .screen = { LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH, DefaultContext.screenBuffer },
+#else
+    .screen = { LCD_WIDTH, LCD_HEIGHT, SCN_ROW_WORDS, DefaultContext.screenBuffer },
+#endif
+    .target = &DefaultContext.screen,
+    .clipRight = LCD_WIDTH,
+    .clipBottom = LCD_HEIGHT
+};
 
-static  uint8  PixelMode;     // Pixel writing mode (see LCD_SetMode fn)
-static  uint16 CursorPosX;    // screen cursor position, X-coord
-static  uint16 CursorPosY;    // screen cursor position, Y-coord
-static  uint8  FontProp;      // Font style (0: monospaced, 1: proportional)
-static  uint8  FontSize;      // Char cell height (pixels)
-static  uint8  FontWeight;    // 0 = Normal;  1 = Bold
+// Selected display context -- the one all API functions act on.  For a host build in which
+// several threads draw, define LCD_THREAD_LOCAL as _Thread_local (C11), so that each thread
+// selects a context of its own.
+#ifndef LCD_THREAD_LOCAL
+#define LCD_THREAD_LOCAL
+#endif
+static  LCD_THREAD_LOCAL  lcdcontext_t  *Ctx = &DefaultContext;
+
+// Display list op-codes.  Each recorded call is stored as an op-code byte, followed
+// by the cursor position and the call arguments (16-bit values are stored LS byte
+// first;  pointers in native format).
+enum  Display_list_opcodes
+{
+    DL_MODE = 1,       // mode
+    DL_FONT,           // font_ID
+    DL_CLIP,           // x, y, w, h
+    DL_RESETCLIP,      // --
+    DL_FILL,           // x, y, w, h
+    DL_IMAGE,          // x, y, w, h, image
+    DL_IMAGE_MASKED,   // x, y, w, h, image, mask
+    DL_SURFACE,        // x, y, w, h, src, sx, sy
+    DL_TEXT,           // x, y, count, chars
+    DL_LINE            // x, y, x1, y1 (end point)
+};
 
 // List of chars that are not rendered in bold typeface...
 static  uint8  NotBoldCharList[] = { '"', '#', 39, ',', '.', ':', ';', '@' };
@@ -429,26 +585,49 @@ static  uint8  NotBoldCharList[] = { '"', '#', 39, ',', '.', ':', ';', '@' };
  * Name               :  LCD_ClearScreen()
  * Function           :  Clear LCD module GDRAM and MCU screen buffer.
  *                       Position graphics cursor at upper LHS = (0, 0).
+ *                       GDRAM is not cleared if nothing has been written to it since
+ *                       it was last cleared.  In batch mode, the clear is deferred:
+ *                       LCD_Flush() then writes the whole screen once, so a clear
+ *                       followed by drawing sends only the final image to the module.
+ *                       (GDRAM written directly by the driver, e.g. a test pattern,
+ *                       is not seen by the library;  call the driver function before
+ *                       the first LCD_ClearScreen(), as the demo does.)
  * Input              :  --
  * Return             :  --
 ------------------------------------------------------------------------------------*/
 void   LCD_ClearScreen(void)
 {
-    int     wordcount = 0;
-    uint16  *pBuf = &screenBuffer[0][0];
+#ifdef LCD_PAGE_MODE
+    Ctx->screenList.length = 0;     // discard all recorded drawing calls
+    Ctx->screenList.full = FALSE;
+#else
+    LCD_FillBytes((uint8 *) Ctx->screenBuffer, sizeof(Ctx->screenBuffer), CLEAR_PIXELS);
+#endif
 
-    while (wordcount++ < 512)
+    if (Ctx->driver == NULL || Ctx->panelBlank)
+    {
+        Ctx->dirtyTiles = 0;   // nothing pending -- GDRAM is already blank
+    }
+    else if (Ctx->batchMode)
+    {
+        Ctx->dirtyTiles = LCD_ALL_TILES;   // LCD_Flush() writes the final image only
+    }
+    else
     {
-        *pBuf++ = 0;
+        Ctx->driver->clearGDRAM();
+        Ctx->panelBlank = TRUE;
+        Ctx->dirtyTiles = 0;   // nothing pending -- GDRAM matches buffer
     }
 
-    LCD_ClearGDRAM();
+    Ctx->pixelMode = SET_PIXELS;
+    Ctx->fontSize = 8;
+    Ctx->fontWeight = 0;
+    Ctx->cursorPosX = 0;
+    Ctx->cursorPosY = 0;
 
-    PixelMode = SET_PIXELS;
-    FontSize = 8;
-    FontWeight = 0;
-    CursorPosX = 0;
-    CursorPosY = 0;
+#ifdef LCD_PAGE_MODE
+    LCD_RecordState();   // replay starts with the same mode, font and clip rectangle
+#endif
 }
 
 
@@ -458,47 +637,91 @@ void   LCD_ClearScreen(void)
  *                       except LCD_ClearScreen() which always clears pixels.
  *                       Default mode after LCD_ClearScreen() is SET_PIXELS.
  *
- * Input              :  mode = CLEAR_PIXELS (0), SET_PIXELS (1), or FLIP_PIXELS (2)
+ * Input              :  mode = CLEAR_PIXELS (0), SET_PIXELS (1), FLIP_PIXELS (2),
+ *                              COPY_PIXELS (3) or AND_PIXELS (4)
+ *
+ * Note               :  COPY and AND modes apply to images and text;  within the image
+ *                       area, COPY sets screen pixels equal to the image pixels (opaque),
+ *                       and AND clears screen pixels where image pixels are clear.
+ *                       Block fill in COPY mode is the same as SET;  in AND mode, no-op.
 ------------------------------------------------------------------------------------*/
 void  LCD_Mode(uint8 mode)
 {
-    PixelMode = mode;
+    Ctx->pixelMode = mode;
+    LCD_RecordSetting(DL_MODE, mode);
 }
 
 
 /*----------------------------------------------------------------------------------
  * Name               :  LCD_PosXY()
- * Function           :  Set graphics cursor position to (x, y) coords
+ * Function           :  Set graphics cursor position to (x, y) coords.
+ *                       The position may be outside the screen, e.g. negative, so that
+ *                       an image or text can be drawn partly off the left or top edge;
+ *                       the part outside the clip rectangle is not drawn.
  * Input              :  x, y coords
 ------------------------------------------------------------------------------------*/
-void  LCD_PosXY(uint16 x, uint16 y)
+void  LCD_PosXY(int16 x, int16 y)
 {
-    CursorPosX = x;
-    CursorPosY = y;
+    Ctx->cursorPosX = x;
+    Ctx->cursorPosY = y;
 }
 
 
 /*----------------------------------------------------------------------------------
  * Name               :  LCD_GetX()
- * Function           :  Returns graphics cursor X-coord (0..127)
+ * Function           :  Returns graphics cursor X-coord (0..LCD_WIDTH-1, if on-screen)
  * Input              :  --
- * Return             :  CursorPosX
+ * Return             :  cursor X-coord
 ------------------------------------------------------------------------------------*/
-uint16  LCD_GetX(void)
+int16  LCD_GetX(void)
 {
-    return CursorPosX;
+    return Ctx->cursorPosX;
 }
 
 
 /*----------------------------------------------------------------------------------
  * Name               :  LCD_GetY()
- * Function           :  Returns graphics cursor Y-coord (0..63)
+ * Function           :  Returns graphics cursor Y-coord (0..LCD_HEIGHT-1, if on-screen)
+ * Input              :  --
+ * Return             :  cursor Y-coord
+------------------------------------------------------------------------------------*/
+int16  LCD_GetY(void)
+{
+    return Ctx->cursorPosY;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_SetClip()
+ *
+ * Function           :  Set the clip rectangle.  All drawing and text functions modify
+ *                       only pixels inside the rectangle, so that a widget can draw
+ *                       within its own bounds without clamping its coordinates.
+ *                       Each function clips its block once, before drawing.
+ *                       The rectangle is limited to the target (screen or surface).
+ *
+ * Input              :  x, y = pixel coords of upper LHS of clip rectangle
+ *                       w, h = width and height of clip rectangle, pixels
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_SetClip(uint16 x, uint16 y, uint16 w, uint16 h)
+{
+    LCD_SetClipRect(x, y, w, h);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_ResetClip()
+ * Function           :  Reset the clip rectangle to the whole target (screen or surface)
  * Input              :  --
- * Return             :  CursorPosY
 ------------------------------------------------------------------------------------*/
-uint16  LCD_GetY(void)
+void  LCD_ResetClip(void)
 {
-    return CursorPosY;
+    LCD_RecordSetting(DL_RESETCLIP, -1);
+    Ctx->clipLeft = 0;
+    Ctx->clipTop = 0;
+    Ctx->clipRight = Ctx->target->width;
+    Ctx->clipBottom = Ctx->target->height;
 }
 
 
@@ -516,78 +739,252 @@ uint16  LCD_GetY(void)
 ------------------------------------------------------------------------------------*/
 void   LCD_BlockFill(uint16 w, uint16 h)
 {
-    uint16  rowBuffer[8];           // pixel pattern for filling whole row
-    int     row, col, i;            // row and column word index for screen buffer
-    int     firstCol;               // first (leftmost) column-word in a row to be modified
-    int     lastCol;                // last (rightmost) column-word in a row to be modified
-    int     offset;                 // shift offset (# of bits) from word boundary
-    uint16  pixelWord;              // bits in column-word to be modified
-    uint8   carryIn, carryOut;
-    int     count;
-    int     x = CursorPosX;
-    int     y = CursorPosY;
+    int     x = Ctx->cursorPosX;
+    int     y = Ctx->cursorPosY;
+    int     width = w;
+    int     height = h;
+    int     sx, sy;                 // not used
 
-    if (x > 127)  x = 0;            // prevent writing past end-of-row
-    if ((x + w) > 128) w = 128 - x;
+    LCD_RecordBlock(DL_FILL, w, h, NULL, NULL);
+    if (Ctx->recording != NULL)  return;   // recorded, not drawn
+    if (!LCD_ClipBlock(&x, &y, &width, &height, &sx, &sy))  return;
 
-    firstCol = x / 16;
-    lastCol = (x + w - 1) / 16;
-    offset = x % 16;
+#ifdef LCD_PAGE_MODE
+    if (Ctx->target == &Ctx->screen)  { LCD_UpdateBlock(x, y, width, height);  return; }
+#endif
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_FillPages(Ctx->target, x, y, width, height);
+#else
+    LCD_FillRows(Ctx->target, x, y, width, height);
+#endif
 
-    for (col = 0;  col < 8;  col++)  // clear row buffer
-    {
-        rowBuffer[col] = 0;
-    }
+    // Update LCD module -- write block (w x h) pixels of screen buffer at (x, y) to GDRAM
+    LCD_UpdateBlock(x, y, width, height);
+}
 
-    // Set w pixels (bits) in row buffer, aligned on word boundary of firstCol
-    for ((count = w, col = firstCol);  col <= lastCol;  col++)
-    {
-        if (count >= 16)
-        {
-            rowBuffer[col] = 0xFFFF;
-            count -= 16;
-        }
-        else  // less than 16 bits remaining
-        {
-            for (i = 0;  i < count;  i++)
-            {
-                rowBuffer[col] >>= 1;
-                rowBuffer[col] |= 0x8000;
-            }
-            break;
-        }
-    }
 
-    // Shift row to the right x bits, in effect, so that first pixel is at x-coord
-    for (i = 0;  i < offset;  i++)
-    {
-        for ((carryIn = 0, col = firstCol);  col <= lastCol;  col++)
-        {
-            carryOut = (uint8) (rowBuffer[col] & 0x0001);  // carry = b0
-            rowBuffer[col] >>= 1;
-            if (carryIn) rowBuffer[col] |= 0x8000;  // b15 = 1
-            else  rowBuffer[col] &= ~0x8000;        // b15 = 0
-            carryIn = carryOut;
-        }
-    }
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_DrawLine()
+ *
+ * Function           :  Draws a straight line, 1 pixel wide, from the graphics cursor
+ *                       position to (x1, y1), including both end points, using the
+ *                       global writing mode (set, clear or flip).  The cursor is moved
+ *                       to (x1, y1), so a polyline is drawn by successive calls.
+ *                       (In FLIP mode, each vertex shared by 2 lines is flipped twice.)
+ *                       The pixels are found by Bresenham's algorithm and written to
+ *                       the buffer a run at a time;  a horizontal or vertical line is a
+ *                       single run.  The LCD module is updated once, for the block
+ *                       enclosing the visible part of the line.
+ *
+ * Input              :  x1, y1 = pixel coords of end point (may be off-screen)
+ *
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_DrawLine(int16 x1, int16 y1)
+{
+    int     x0 = Ctx->cursorPosX;
+    int     y0 = Ctx->cursorPosY;
+    int     x = MIN(x0, x1);
+    int     y = MIN(y0, y1);
+    int     width = (x1 > x0) ? (x1 - x0 + 1) : (x0 - x1 + 1);
+    int     height = (y1 > y0) ? (y1 - y0 + 1) : (y0 - y1 + 1);
+    int     sx, sy;                 // not used
 
-    // Update screen buffer
-    for (row = y;  row < (y + h) && row < 64;  row++)
-    {
-        for (col = firstCol;  col <= lastCol && col < 8;  col++)
-        {
-            pixelWord = screenBuffer[row][col];
+    LCD_RecordBlock(DL_LINE, x1, y1, NULL, NULL);
+    Ctx->cursorPosX = x1;
+    Ctx->cursorPosY = y1;
+    if (Ctx->recording != NULL)  return;   // recorded, not drawn
+    if (!LCD_ClipBlock(&x, &y, &width, &height, &sx, &sy))  return;
 
-            if (PixelMode == SET_PIXELS) pixelWord |= rowBuffer[col];
-            else if (PixelMode == CLEAR_PIXELS) pixelWord &= ~rowBuffer[col];
-            else  pixelWord ^= rowBuffer[col];  // FLIP_PIXELS
+#ifdef LCD_PAGE_MODE
+    if (Ctx->target == &Ctx->screen)  { LCD_UpdateBlock(x, y, width, height);  return; }
+#endif
+    if (x0 == x1 || y0 == y1)  LCD_FillRun(Ctx->target, x, y, width, height);
+    else  LCD_DrawLineRuns(Ctx->target, x0, y0, x1, y1, x, y, width, height);
 
-            screenBuffer[row][col] = pixelWord;
-        }
-    }
+    // Update LCD module -- write block enclosing the line to GDRAM
+    LCD_UpdateBlock(x, y, width, height);
+}
 
-    // Update LCD module -- write block (w x h) pixels of screen buffer at (x, y) to GDRAM
-    LCD_WriteBlock((uint16 *) screenBuffer, x, y, w, h);
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_FillScreen()
+ *
+ * Function           :  Fill the whole target (screen or surface) within the clip
+ *                       rectangle, using the global writing mode (set, clear or flip),
+ *                       as LCD_BlockFill() does.  If the clip rectangle is the whole
+ *                       target, the buffer is filled a machine word at a time, without
+ *                       regard to the row or page layout.  Cursor position unchanged.
+ * Input              :  --
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_FillScreen(void)
+{
+    LCD_FillTarget(Ctx->pixelMode);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_InvertScreen()
+ * Function           :  Flip every pixel of the target within the clip rectangle, e.g.
+ *                       to flash the screen, whatever the writing mode (see LCD_FillScreen).
+ * Input              :  --
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_InvertScreen(void)
+{
+    LCD_FillTarget(FLIP_PIXELS);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_CountScreenPixels()
+ * Function           :  Count the pixels which are set in the whole target (screen or
+ *                       surface), a machine word at a time.  The clip rectangle does
+ *                       not apply.
+ * Input              :  --
+ * Return             :  number of pixels set (32 bits -- a surface may hold more than
+ *                       65535 pixels);  0 in page mode, if the target is the screen
+ *                       (which has no buffer)
+------------------------------------------------------------------------------------*/
+uint32  LCD_CountScreenPixels(void)
+{
+    surface_t  *dst = Ctx->target;
+
+    if (dst->bits == NULL)  return 0;
+
+    return  LCD_CountBytes((uint8 *) dst->bits,
+                           SURFACE_WORDS(dst->width, dst->height) * sizeof(scnword_t));
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_CompareScreen()
+ *
+ * Function           :  Compare the whole target (screen or surface) with another surface,
+ *                       a machine word at a time, e.g. to test whether a new frame
+ *                       differs from the one on screen before drawing it.  The clip
+ *                       rectangle does not apply.
+ *
+ * Input              :  src = surface to compare with the target
+ * Return             :  TRUE if the surfaces are the same size, with the same pixels set;
+ *                       FALSE if not, or in page mode, if the target is the screen
+------------------------------------------------------------------------------------*/
+bool  LCD_CompareScreen(surface_t *src)
+{
+    surface_t  *dst = Ctx->target;
+
+    if (dst->bits == NULL || src->bits == NULL)  return FALSE;
+    if (src->width != dst->width || src->height != dst->height)  return FALSE;
+
+    return  LCD_CompareBytes((uint8 *) dst->bits, (uint8 *) src->bits,
+                             SURFACE_WORDS(dst->width, dst->height) * sizeof(scnword_t));
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_GetPixel()
+ * Function           :  Read a pixel of the target (screen or surface).
+ *                       The cursor position and the buffer are not affected.
+ * Input              :  x, y = pixel coords
+ * Return             :  1 if the pixel is set;  0 if clear or outside the target, or in
+ *                       page mode, if the target is the screen (which has no buffer)
+------------------------------------------------------------------------------------*/
+uint8  LCD_GetPixel(int16 x, int16 y)
+{
+    surface_t  *src = Ctx->target;
+
+    if (src->bits == NULL || x < 0 || y < 0 || x >= src->width || y >= src->height)
+        return 0;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    return  (src->bits[(y / 8) * src->stride + x] >> (y % 8)) & 1;
+#else
+    return  (src->bits[y * src->stride + x / SCN_WORD_BITS]
+             >> (SCN_WORD_BITS - 1 - x % SCN_WORD_BITS)) & 1;
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_CountPixels()
+ *
+ * Function           :  Count the pixels which are set in a block of the target (screen
+ *                       or surface), e.g. to measure the fill of a gauge or the overlap
+ *                       of two objects.  The buffer is read a word at a time, with the
+ *                       first and last words in each row (or the first and last pages)
+ *                       masked as for a block fill.  The block is clipped to the target,
+ *                       but not to the clip rectangle.  Cursor position unchanged.
+ *
+ * Input              :  x, y = pixel coords of upper LHS of block
+ *                       w, h = width and height of block, pixels
+ *
+ * Return             :  number of pixels set in the block (32 bits, as for
+ *                       LCD_CountScreenPixels);  0 in page mode, if the target is the screen
+------------------------------------------------------------------------------------*/
+uint32  LCD_CountPixels(int16 x, int16 y, uint16 w, uint16 h)
+{
+    surface_t  *src = Ctx->target;
+    int     left = x;
+    int     top = y;
+    int     right = x + w;
+    int     bottom = y + h;
+
+    if (left < 0)  left = 0;
+    if (top < 0)  top = 0;
+    if (right > src->width)  right = src->width;
+    if (bottom > src->height)  bottom = src->height;
+    if (src->bits == NULL || left >= right || top >= bottom)  return 0;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    return  LCD_CountPages(src, left, top, right - left, bottom - top);
+#else
+    return  LCD_CountRows(src, left, top, right - left, bottom - top);
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_TestImage()
+ *
+ * Function           :  Test whether a bitmap image drawn at (x, y) would collide with
+ *                       pixels already set in the target (screen or surface), without
+ *                       drawing it:  the buffer is not modified and the display is not
+ *                       updated.  The image is aligned to the buffer words as it would
+ *                       be by LCD_PutImage(), and the test ends at the first collision.
+ *                       The image is clipped to the clip rectangle, as if drawn.
+ *                       Cursor position unchanged.
+ *
+ * Input              :  (bitmap_t *) imageData = pointer to bit-map image data
+ *                       (see LCD_PutImage)
+ *                       x, y = pixel coords of upper LHS of image
+ *                       w, h = image width and height, pixels
+ *
+ * Return             :  TRUE (1) if LCD_PutImage() at (x, y) would return TRUE, i.e. any
+ *                       image pixel which is set falls on a pixel already set;  otherwise
+ *                       FALSE (0), also in page mode, if the target is the screen
+------------------------------------------------------------------------------------*/
+uint8  LCD_TestImage(bitmap_t *imageData, int16 x, int16 y, uint16 w, uint16 h)
+{
+    int     imageBytesInRow = (w / 8) + ((w % 8) ? 1 : 0);
+    int     left = x;
+    int     top = y;
+    int     width = w;
+    int     height = h;
+    int     sx, sy;
+
+    if (Ctx->target->bits == NULL)  return 0;
+    if (!LCD_ClipBlock(&left, &top, &width, &height, &sx, &sy))  return 0;
+
+    imageData += sy * imageBytesInRow;    // skip rows above clip rectangle
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    return  LCD_PutImagePagesOp(Ctx->target, (uint8 *) imageData, NULL, left, top,
+                                width, height, imageBytesInRow, sx, TEST_PIXELS, TRUE, NULL);
+#else
+    return  LCD_PutImageRowsOp(Ctx->target, (uint8 *) imageData, NULL, left, top,
+                               width, height, imageBytesInRow, sx, TEST_PIXELS, TRUE, NULL);
+#endif
 }
 
 
@@ -595,7 +992,7 @@ void   LCD_BlockFill(uint16 w, uint16 h)
  * Name               :  LCD_PutImage()
  *
  * Function           :  Render bitmap image at current (x, y) using currently
- *                       selected writing mode (i.e. set, clear or flip pixels).
+ *                       selected writing mode (i.e. set, clear, flip, copy or AND).
  *                       Cursor position is not affected.
  *
  *                       The bitmap image is assumed to be an array of bytes, ordered
@@ -612,87 +1009,214 @@ void   LCD_BlockFill(uint16 w, uint16 h)
 ------------------------------------------------------------------------------------*/
 uint8   LCD_PutImage(bitmap_t *imageData, uint16 w, uint16 h)
 {
-    uint16  rowBuffer[8];           // row of 128 pixels forming the image
-    int     row, col, i;            // row and column word index for screen buffer
-    int     firstCol;               // first (leftmost) column-word in a row to be modified
-    int     lastCol;                // last (rightmost) column-word in a row to be modified
-    int     offset;                 // shift offset (# of bits) from word boundary
-    uint16  pixelWord;              // bits in column-word to be modified
-    uint8  *pData;
-    uint16  bitmask;
-    uint8   carryIn, carryOut;
-    int     count;
-    int     imageBytesInRow;        // minimum number of bytes to hold w pixels (1 row)
-    uint8   collision = 0;          // return value (0 or 1)
-    uint16  x = CursorPosX;
-    uint16  y = CursorPosY;
+    LCD_RecordBlock(DL_IMAGE, w, h, imageData, NULL);
+    return  LCD_BlitImage(imageData, NULL, w, h, TRUE);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_DrawImage()
+ *
+ * Function           :  Render bitmap image at current (x, y) using currently
+ *                       selected writing mode, as LCD_PutImage(), except that there
+ *                       is no test for collision with pixels already set, so the
+ *                       image is rendered faster.
+ *
+ * Input              :  (bitmap_t *) imageData = pointer to bit-map image data
+ *                       (uint16)  w = image width, h = image height, pixels
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void    LCD_DrawImage(bitmap_t *imageData, uint16 w, uint16 h)
+{
+    LCD_RecordBlock(DL_IMAGE, w, h, imageData, NULL);
+    LCD_BlitImage(imageData, NULL, w, h, FALSE);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_PutImageMasked()
+ *
+ * Function           :  Render bitmap image at current (x, y) with transparency, in a
+ *                       single pass.  Where a pixel in the mask is set (=1), the screen
+ *                       pixel is copied from the image (set or cleared);  where a mask
+ *                       pixel is clear (=0), the screen pixel is unchanged.
+ *                       The writing mode (LCD_Mode) does not apply.
+ *                       Cursor position is not affected.
+ *
+ * Input              :  (bitmap_t *) imageData = pointer to bit-map image data
+ *                       (bitmap_t *) maskData = pointer to mask bit-map, same size and
+ *                                    format as the image (see LCD_PutImage)
+ *                       (uint16)  w = image width, h = image height, pixels
+ *
+ * Return             :  TRUE (1) if any image pixel which is set within the mask AND
+ *                       the corresponding pixel on the screen is already set (=1) before
+ *                       the image is written;  otherwise return FALSE (0).
+------------------------------------------------------------------------------------*/
+uint8   LCD_PutImageMasked(bitmap_t *imageData, bitmap_t *maskData, uint16 w, uint16 h)
+{
+    LCD_RecordBlock(DL_IMAGE_MASKED, w, h, imageData, maskData);
+    return  LCD_BlitImage(imageData, maskData, w, h, TRUE);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_GetCollision()
+ *
+ * Function           :  Get the collision report of the last call to LCD_PutImage() or
+ *                       LCD_PutImageMasked():  the number of image pixels which fell on
+ *                       pixels already set, and the bounding box of those pixels.
+ *                       The report is formed by the image kernel in the same pass as the
+ *                       image is drawn, only for words (or bytes) which collide.
+ *
+ * Input              :  info = pointer to struct to receive the report;  if there was no
+ *                              collision, count is 0 and the bounding box is empty (0)
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_GetCollision(collision_t *info)
+{
+    *info = Ctx->collision;
+}
+
 
-    if (x > 127)  x = 0;            // prevent writing past end-of-row
-    if ((x + w) > 128) w = 128 - x;
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_BlitImage()
+ *
+ * Function           :  Common code for LCD_PutImage(), LCD_DrawImage() and
+ *                       LCD_PutImageMasked().
+ *
+ * Input              :  (bitmap_t *) imageData = pointer to bit-map image data
+ *                       (bitmap_t *) maskData = pointer to mask bit-map, or NULL
+ *                       (uint16)  w = image width, h = image height, pixels
+ *                       checkCollision = TRUE to test image pixels against screen
+ *
+ * Return             :  TRUE (1) if checkCollision is TRUE and any image pixel collides
+ *                       with a pixel already set;  otherwise FALSE (0).
+ *                       If checkCollision is TRUE, the collision report (count and
+ *                       bounding box of colliding pixels) is formed in the same pass.
+ *                       In page mode (LCD_PAGE_MODE), the screen pixels are not known
+ *                       until the page is rendered, so the screen never collides.
+------------------------------------------------------------------------------------*/
+PRIVATE  uint8  LCD_BlitImage(bitmap_t *imageData, bitmap_t *maskData, uint16 w, uint16 h,
+                              bool checkCollision)
+{
+    int     imageBytesInRow;        // minimum number of bytes to hold w pixels (1 row)
+    uint8   collision;              // return value (0 or 1)
+    int     x = Ctx->cursorPosX;
+    int     y = Ctx->cursorPosY;
+    int     width = w;              // width and height of visible part of image
+    int     height = h;
+    int     sx, sy;                 // first visible column and row of image
+    collision_t  *info = NULL;      // collision report, if wanted
 
-    firstCol = x / 16;
-    lastCol = (x + w - 1) / 16;
-    offset = x % 16;
     imageBytesInRow = (w / 8) + ((w % 8) ? 1 : 0);
 
-    for (row = y;  row < (y + h) && row < 64;  row++)
+    if (checkCollision)
     {
-        pData = (uint8 *)imageData + ((row - y) * imageBytesInRow);  // point to (next) row
-        rowBuffer[lastCol] = 0;  // clear garbage
+        info = &Ctx->collision;
+        memset(info, 0, sizeof(collision_t));
+    }
+    if (Ctx->recording != NULL)  return 0;   // recorded, not drawn
+    if (!LCD_ClipBlock(&x, &y, &width, &height, &sx, &sy))  return 0;
 
-        // Copy row of image data to row buffer, aligned on word boundary of firstCol
-        for ((count = w, col = firstCol);  col <= lastCol;  col++)
-        {
-            rowBuffer[col] = (uint16) *pData << 8;   // High-order (left) byte
-            pData++;
-            rowBuffer[col] |= (uint16) *pData;   // Low-order (right) byte, maybe garbage
-            pData++;
+#ifdef LCD_PAGE_MODE
+    if (Ctx->target == &Ctx->screen)  { LCD_UpdateBlock(x, y, width, height);  return 0; }
+#endif
+    imageData += sy * imageBytesInRow;    // skip rows above clip rectangle
+    if (maskData != NULL)  maskData += sy * imageBytesInRow;
 
-            if (count < 16)  // less than 16 bits remaining
-            {
-                bitmask = 0x0000;
-                for (i = 0;  i < count;  i++)
-                {
-                    bitmask >>= 1;
-                    bitmask |= 0x8000;
-                }
-                rowBuffer[col] &= bitmask;  // mask off "out of bounds" pixels
-                break;
-            }
-            else  count -= 16;  // next col.
-        }
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    collision = LCD_PutImagePages(Ctx->target, (uint8 *) imageData, (uint8 *) maskData,
+                                  x, y, width, height, imageBytesInRow, sx, info);
+#else
+    collision = LCD_PutImageRows(Ctx->target, (uint8 *) imageData, (uint8 *) maskData,
+                                 x, y, width, height, imageBytesInRow, sx, info);
+#endif
+
+    // Update LCD module -- write block (w x h) pixels of screen buffer at (x, y) to GDRAM
+    LCD_UpdateBlock(x, y, width, height);
+
+    return  collision;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_BeginBatch()
+ *
+ * Function           :  Start deferred rendering (batch) mode.
+ *                       Subsequent drawing functions modify the MCU screen buffer only;
+ *                       the LCD module GDRAM is not updated until LCD_Flush() is called.
+ *                       Modified areas are tracked in tiles of 16 x 8 pixels, i.e. the
+ *                       units the controller drivers transfer, so the flush writes each
+ *                       modified tile once, however many times it was drawn over.
+ * Input              :  --
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_BeginBatch(void)
+{
+    Ctx->batchMode = TRUE;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_Flush()
+ *
+ * Function           :  Write the area of the screen buffer modified since the last
+ *                       flush (if any) to the LCD module GDRAM, and end batch mode.
+ *                       In page mode, each page with any modified tiles is rendered
+ *                       from the display list and written to GDRAM;  likewise, if the
+ *                       screen is rotated, from the rotated screen buffer.
+ *                       Drawing functions called after LCD_Flush() update the LCD
+ *                       module immediately, until LCD_BeginBatch() is called again.
+ * Input              :  --
+ * Return             :  FALSE if, in page mode, the screen list has overflowed since
+ *                       LCD_ClearScreen(), so drawing calls were lost (the screen is
+ *                       not as drawn);  else TRUE
+------------------------------------------------------------------------------------*/
+bool  LCD_Flush(void)
+{
+    int     page;
+#ifndef LCD_PAGE_MODE
+    int     col;
+    int     firstCol;               // first (leftmost) tile in a run of dirty tiles
+#endif
+    uint32  dirtyCols;              // dirty tile flags for 1 page, bit N = col N
+
+    Ctx->batchMode = FALSE;
 
-        // Shift row to the right x bits, in effect, so that first pixel is at x-coord
-        for (i = 0;  i < offset;  i++)
+    for (page = 0;  page < LCD_PAGES && Ctx->dirtyTiles != 0;  page++)
+    {
+        dirtyCols = (uint32) (Ctx->dirtyTiles >> (page * LCD_TILE_COLS))
+                    & (((uint32) 1 << LCD_TILE_COLS) - 1);
+#ifdef LCD_PAGE_MODE
+        if (dirtyCols != 0)  LCD_RenderPage(page);   // whole page -- no buffer to copy from
+#else
+#ifdef LCD_ROTATION
+        if (Ctx->rotation != ROTATE_0)
         {
-            for ((carryIn = 0, col = firstCol);  col <= lastCol;  col++)
-            {
-                carryOut = (uint8) (rowBuffer[col] & 0x0001);  // carry = b0
-                rowBuffer[col] >>= 1;
-                if (carryIn) rowBuffer[col] |= 0x8000;  // b15 = 1
-                else  rowBuffer[col] &= ~0x8000;        // b15 = 0
-                carryIn = carryOut;
-            }
+            if (dirtyCols != 0)  LCD_RenderRotatedPage(page);   // whole page, rotated
+            continue;
         }
-
-        // Update 1 row in screen buffer
-        for (col = firstCol;  col <= lastCol && col < 8;  col++)
+#endif
+        // Write each run of adjacent dirty tiles in the page as a single block
+        for (col = 0;  dirtyCols != 0;  )
         {
-            pixelWord = screenBuffer[row][col];
-            if (pixelWord & rowBuffer[col]) collision = 1;
+            while ((dirtyCols & 1) == 0)  { dirtyCols >>= 1;  col++; }
+            firstCol = col;
+            while (dirtyCols & 1)  { dirtyCols >>= 1;  col++; }
 
-            if (PixelMode == SET_PIXELS) pixelWord |= rowBuffer[col];
-            else if (PixelMode == CLEAR_PIXELS) pixelWord &= ~rowBuffer[col];
-            else  pixelWord ^= rowBuffer[col];  // FLIP_PIXELS
-
-            screenBuffer[row][col] = pixelWord;
+            Ctx->driver->writeBlock(Ctx->screenBuffer, firstCol * LCD_TILE_WIDTH,
+                                    page * 8, (col - firstCol) * LCD_TILE_WIDTH, 8);
         }
+#endif
     }
 
-    // Update LCD module -- write block (w x h) pixels of screen buffer at (x, y) to GDRAM
-    LCD_WriteBlock((uint16 *) screenBuffer, x, y, w, h);
+    Ctx->dirtyTiles = 0;
 
-    return  collision;
+#ifdef LCD_PAGE_MODE
+    return  !Ctx->screenList.full;
+#else
+    return  TRUE;
+#endif
 }
 
 
@@ -701,94 +1225,613 @@ uint8   LCD_PutImage(bitmap_t *imageData, uint16 w, uint16 h)
  * Function           :  Return a pointer to the screen buffer.
  *                       The buffer is 512 words ordered as screenBuffer[rows][cols],
  *                       where rows == 64 and cols == 8. Each column is 16 pixels.
+ *                       If LCD_BUFFER_WORD32 is defined, the buffer is 256 words
+ *                       (32 bits) ordered as above, where cols == 4.
+ *                       If LCD_BUFFER_PAGE_MAJOR is defined, the buffer is 1024 bytes
+ *                       ordered as screenBuffer[pages][cols], where pages == 8 and
+ *                       cols == 128. Each byte is 8 pixels vertical, bit 0 at the top.
+ *                       (Sizes are for a 128 x 64 panel:  rows == LCD_HEIGHT, pages ==
+ *                       LCD_PAGES, cols == SCN_ROW_WORDS, or LCD_WIDTH if page-major.)
+ *                       If the screen is rotated 90 or 270 degrees, the buffer holds
+ *                       the screen in portrait orientation, LCD_HEIGHT x LCD_WIDTH.
  *
  * Note               :  The screenBuffer[] array is not ordered the same as the GDRAM
  *                       memory in the ST7920 LCD controller.
  *                       (See LCD_ClearScreen() for a map of the ST7920 GDRAM buffer.)
  * Input              :  --
- * Return             :  (uint16 *) address of local screenBuffer[]
+ * Return             :  (scnword_t *) address of screenBuffer[] in the selected context;
+ *                       NULL in page mode (LCD_PAGE_MODE), which has no screen buffer.
 ------------------------------------------------------------------------------------*/
-uint16  *LCD_ScreenCapture()
+scnword_t  *LCD_ScreenCapture()
 {
-    return  (uint16 *) &screenBuffer[0][0];
+#ifdef LCD_PAGE_MODE
+    return  NULL;
+#else
+    return  Ctx->screenBuffer;
+#endif
 }
 
 
 /*----------------------------------------------------------------------------------
- * Name               :  LCD_SetFont()
- * Function           :  Set font style for text display using functions...
- *                       LCD_PutChar(), LCD_PutText(), etc.
+ * Name               :  LCD_InitSurface()
  *
- * Input              :  uint8  font_ID = one of the following...
- * 
- *    MONO_8_NORM      Mono-spaced font;  char width is 5 pix
- *    PROP_8_NORM      Proportional font;  char width is 3..5 pix
- *    PROP_12_NORM     Proportional font;  char width is 4..7 pix
- *    PROP_12_BOLD     as above, but bold weight (width + 1)
- *    MONO_16_NORM     Mono-spaced font;  char width is 10 pix
- *    MONO_16_BOLD     as above, but bold weight (width + 1)
- *    PROP_24_NORM     Proportional font;  char width is 7..15 pix
- * 
+ * Function           :  Initialise an off-screen drawing surface of w x h pixels, using
+ *                       a pixel buffer supplied by the caller, and clear all its pixels.
+ *                       The buffer format is the same as the screen buffer (see
+ *                       LCD_ScreenCapture), so that the same drawing functions apply.
+ *
+ * Input              :  surface = pointer to surface struct to be initialised
+ *                       bits = pointer to buffer of at least SURFACE_WORDS(w, h) words
+ *                       w, h = surface width and height, pixels
+ * Return             :  --
 ------------------------------------------------------------------------------------*/
-void   LCD_SetFont(uint8 font_ID)
+void  LCD_InitSurface(surface_t *surface, scnword_t *bits, uint16 w, uint16 h)
 {
-    FontWeight = font_ID & 1;            // b0 (0: normal, 1: bold)
-    FontProp = (font_ID >> 1) & 1;       // b1 (0: monospaced, 1: proportional)
-    FontSize = 8 + 4 * (font_ID >> 2);   // b3:b2 (0: 8p, 1: 12p, 2: 16p, 3: 24p)
-    if (font_ID >= 12) FontSize = 24;    // corrected
+    int     i;
+
+    surface->width = w;
+    surface->height = h;
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    surface->stride = w;    // bytes per page
+#else
+    surface->stride = (w + SCN_WORD_BITS - 1) / SCN_WORD_BITS;   // column-words per row
+#endif
+    surface->bits = bits;
+
+    for (i = 0;  i < (int) SURFACE_WORDS(w, h);  i++)
+    {
+        bits[i] = 0;
+    }
 }
 
 
 /*----------------------------------------------------------------------------------
- * Name               :  LCD_GetFont()
- * Function           :  Get current font ID setting
+ * Name               :  LCD_SetTarget()
  *
- * Input              :  --
- * Return             :  uint8  font_ID = 0 .. 15
+ * Function           :  Select the surface to be modified by all subsequent drawing and
+ *                       text functions.  While an off-screen surface is selected, the
+ *                       display is not updated, and the cursor position and clipping
+ *                       apply to the surface.  The clip rectangle is reset to the whole
+ *                       of the new target.
+ *
+ * Input              :  surface = pointer to surface, or NULL to select the screen
+ * Return             :  --
 ------------------------------------------------------------------------------------*/
-uint8  LCD_GetFont()
+void  LCD_SetTarget(surface_t *surface)
 {
-    uint8  size_id = (FontSize - 8) / 4;   // 0, 1, 2, 4
+    if (surface == NULL)  Ctx->target = &Ctx->screen;
+    else  Ctx->target = surface;
 
-    if (size_id == 4) size_id = 3;  // corrected
-
-    return  (size_id << 2) + (FontProp << 1) + FontWeight;
+    LCD_ResetClip();
 }
 
 
 /*----------------------------------------------------------------------------------
- * Name               :  LCD_PutChar()
- * Function           :  Show ASCII char at current (x, y) using selected font.
- * Input              :  (uint8) uc = ASCII char to be displayed
- * Return             :  --
+ * Name               :  LCD_GetTarget()
+ *
+ * Function           :  Return a pointer to the surface modified by drawing functions.
+ *
+ * Input              :  --
+ * Return             :  (surface_t *) target surface;  the screen if none was selected
 ------------------------------------------------------------------------------------*/
-void   LCD_PutChar(char uc)
+surface_t  *LCD_GetTarget()
 {
-    if (FontSize >= 24)  LCD_PutChar24(uc);
-    else if (FontSize >= 16)  LCD_PutChar16(uc);
-    else if (FontSize >= 12)  LCD_PutChar12(uc);
-    else  LCD_PutChar8(uc);
+    return  Ctx->target;
 }
 
 
 /*----------------------------------------------------------------------------------
- * Name               :  LCD_PutText()
+ * Name               :  LCD_PutSurface()
+ *
+ * Function           :  Copy a block of w x h pixels at (sx, sy) in the source surface
+ *                       to the target (screen or surface) at the current cursor position,
+ *                       using the currently selected writing mode.  Each target word is
+ *                       formed from two source words by a single shift-and-merge.
+ *                       The block is clipped to the source and to the clip rectangle.
+ *                       The source and target must not be the same surface.
+ *
+ * Input              :  src = pointer to source surface
+ *                       sx, sy = pixel coords of upper LHS of block in source surface
+ *                       w, h = width and height of block, pixels
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_PutSurface(surface_t *src, uint16 sx, uint16 sy, uint16 w, uint16 h)
+{
+    int     x = Ctx->cursorPosX;
+    int     y = Ctx->cursorPosY;
+    int     width, height;
+    int     dx, dy;                 // offset of visible part of block
+    displist_t  *list;
+
+    if (sx >= src->width || sy >= src->height)  return;
+    if ((sx + w) > src->width)  w = src->width - sx;
+    if ((sy + h) > src->height)  h = src->height - sy;
+
+    list = LCD_GetRecorder(FALSE);
+    if (list != NULL && LCD_ListBegin(list, DL_SURFACE, 13 + sizeof(void *)))
+    {
+        LCD_ListPut16(list, x);
+        LCD_ListPut16(list, y);
+        LCD_ListPut16(list, w);
+        LCD_ListPut16(list, h);
+        LCD_ListPutPtr(list, src);
+        LCD_ListPut16(list, sx);
+        LCD_ListPut16(list, sy);
+    }
+    if (Ctx->recording != NULL)  return;   // recorded, not drawn
+
+    width = w;
+    height = h;
+    if (!LCD_ClipBlock(&x, &y, &width, &height, &dx, &dy))  return;
+#ifdef LCD_PAGE_MODE
+    if (Ctx->target == &Ctx->screen)  { LCD_UpdateBlock(x, y, width, height);  return; }
+#endif
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_BlitSurfacePages(Ctx->target, src, sx + dx, sy + dy, x, y, width, height);
+#else
+    LCD_BlitSurfaceRows(Ctx->target, src, sx + dx, sy + dy, x, y, width, height);
+#endif
+
+    // Update LCD module -- write block (w x h) pixels of screen buffer at (x, y) to GDRAM
+    LCD_UpdateBlock(x, y, width, height);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_ScrollRegion()
+ *
+ * Function           :  Move the pixels in a block (w x h) at the current cursor position
+ *                       by dx pixels to the right and dy pixels down (negative values move
+ *                       left or up), within the block.  Pixels moved outside the block are
+ *                       discarded;  the strip exposed at the opposite edge is cleared,
+ *                       ready for new content (e.g. the next line of a log, or the next
+ *                       sample of a strip chart).  Only the block is updated on the display.
+ *                       Pixels are moved within the screen buffer, by word shifts and row
+ *                       copies, so scrolling costs much less than redrawing the block.
+ *                       The block is clipped to the clip rectangle before it is moved.
+ *                       In page mode (LCD_PAGE_MODE), only off-screen surfaces can scroll.
+ *
+ * Input              :  w, h = width and height of block, pixels
+ *                       dx, dy = distance to move pixels right and down, pixels
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_ScrollRegion(uint16 w, uint16 h, int dx, int dy)
+{
+    int     x = Ctx->cursorPosX;
+    int     y = Ctx->cursorPosY;
+    int     width = w;
+    int     height = h;
+    int     sx, sy;                 // not used
+
+#ifdef LCD_PAGE_MODE
+    if (Ctx->target == &Ctx->screen)  return;     // no screen pixels to move
+#endif
+    if (!LCD_ClipBlock(&x, &y, &width, &height, &sx, &sy))  return;
+    if (dx == 0 && dy == 0)  return;
+
+    if (dx > width)  dx = width;       // block is cleared if moved entirely out of itself
+    if (dx < -width)  dx = -width;
+    if (dy > height)  dy = height;
+    if (dy < -height)  dy = -height;
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_ScrollPages(Ctx->target, x, y, width, height, dx, dy);
+#else
+    LCD_ScrollRows(Ctx->target, x, y, width, height, dx, dy);
+#endif
+
+    // Update LCD module -- write block (w x h) pixels of screen buffer at (x, y) to GDRAM
+    LCD_UpdateBlock(x, y, width, height);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_SaveRegion()
+ *
+ * Function           :  Save the pixels in a rectangular area of the target (normally
+ *                       the screen), e.g. before drawing a pop-up or menu over it, so
+ *                       that the area can be put back later by LCD_RestoreRegion().
+ *                       The pixels are saved aligned to the words of the target, so that
+ *                       saving and restoring are word copies, masked at the edges.
+ *
+ *                       If buffer is NULL, a buffer is allocated from a pool of
+ *                       LCD_REGION_POOL_WORDS.  Pool buffers are freed on restore, so
+ *                       nested regions must be restored in reverse order of saving.
+ *
+ * Input              :  region = pointer to region struct to hold the saved area
+ *                       buffer = buffer of at least REGION_WORDS(w, h) words, or NULL
+ *                       x, y = pixel coords of upper LHS of area
+ *                       w, h = width and height of area, pixels
+ *
+ * Return             :  TRUE if the area was saved;  FALSE if it lies outside the
+ *                       target or there is not enough space left in the pool, or if
+ *                       the target is the screen in page mode (LCD_PAGE_MODE).
+------------------------------------------------------------------------------------*/
+bool  LCD_SaveRegion(region_t *region, scnword_t *buffer, uint16 x, uint16 y,
+                     uint16 w, uint16 h)
+{
+    int     words;                  // buffer size needed, words
+    uint8   mode = Ctx->pixelMode;
+
+    region->w = 0;
+#ifdef LCD_PAGE_MODE
+    if (Ctx->target == &Ctx->screen)  return FALSE;   // no screen pixels to save
+#endif
+    if (x >= Ctx->target->width || y >= Ctx->target->height || w == 0 || h == 0)  return FALSE;
+    if ((x + w) > Ctx->target->width)  w = Ctx->target->width - x;
+    if ((y + h) > Ctx->target->height)  h = Ctx->target->height - y;
+
+    region->poolOffset = -1;
+    if (buffer == NULL)   // allocate from pool
+    {
+        words = REGION_WORDS(w, h);
+        if ((Ctx->regionPoolUsed + words) > LCD_REGION_POOL_WORDS)  return FALSE;
+#if LCD_REGION_POOL_WORDS > 0
+        region->poolOffset = Ctx->regionPoolUsed;
+        buffer = &Ctx->regionPool[Ctx->regionPoolUsed];
+        Ctx->regionPoolUsed += words;
+#endif
+    }
+
+    region->target = Ctx->target;
+    region->x = x;
+    region->y = y;
+    region->w = w;
+    region->h = h;
+
+    Ctx->pixelMode = COPY_PIXELS;
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_InitSurface(&region->saved, buffer, w, (y % 8) + h);
+    LCD_BlitSurfacePages(&region->saved, Ctx->target, x, y, 0, y % 8, w, h);
+#else
+    LCD_InitSurface(&region->saved, buffer, (x % SCN_WORD_BITS) + w, h);
+    LCD_BlitSurfaceRows(&region->saved, Ctx->target, x, y, x % SCN_WORD_BITS, 0, w, h);
+#endif
+    Ctx->pixelMode = mode;
+
+    return TRUE;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_RestoreRegion()
+ *
+ * Function           :  Put back the pixels saved by LCD_SaveRegion() in the surface
+ *                       from which they were saved.  If this is the screen, only the
+ *                       restored area is written to the display (or marked for update,
+ *                       in batch mode).  A pool buffer held by the region is freed.
+ *
+ * Input              :  region = pointer to region saved by LCD_SaveRegion()
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_RestoreRegion(region_t *region)
+{
+    surface_t  *target = Ctx->target;
+    uint8   mode = Ctx->pixelMode;
+
+    if (region->w == 0)  return;     // nothing saved
+
+    Ctx->target = region->target;
+    Ctx->pixelMode = COPY_PIXELS;
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_BlitSurfacePages(Ctx->target, &region->saved, 0, region->y % 8,
+                         region->x, region->y, region->w, region->h);
+#else
+    LCD_BlitSurfaceRows(Ctx->target, &region->saved, region->x % SCN_WORD_BITS, 0,
+                        region->x, region->y, region->w, region->h);
+#endif
+    Ctx->pixelMode = mode;
+
+    LCD_UpdateBlock(region->x, region->y, region->w, region->h);
+    Ctx->target = target;
+
+    if (region->poolOffset >= 0)   // free pool buffer, if it is the last allocated
+    {
+        if (region->poolOffset + REGION_WORDS(region->w, region->h) == Ctx->regionPoolUsed)
+            Ctx->regionPoolUsed = region->poolOffset;
+        region->w = 0;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_BeginRecord()
+ *
+ * Function           :  Start recording drawing calls in a display list, so that the
+ *                       same screen (or part of one) can be drawn later, any number of
+ *                       times, without repeating the work done by the calls, e.g. font
+ *                       expansion.  Until LCD_EndRecord() is called, these calls are
+ *                       recorded in the list, instead of being drawn:
+ *
+ *    LCD_Mode, LCD_SetFont, LCD_SetClip, LCD_ResetClip, LCD_BlockFill, LCD_PutImage,
+ *    LCD_DrawImage, LCD_PutImageMasked, LCD_PutSurface, LCD_PutChar, LCD_PutText,
+ *    LCD_FillScreen, LCD_InvertScreen (recorded as block fills), LCD_DrawLine
+ *
+ *                       The calls still change the settings and advance the cursor, as
+ *                       if drawn.  Text is copied into the list;  images and surfaces
+ *                       are recorded by reference, so must not change while in use.
+ *
+ * Input              :  list = pointer to display list struct to be initialised
+ *                       buffer = buffer for recorded calls
+ *                       size = buffer size, bytes
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_BeginRecord(displist_t *list, uint8 *buffer, uint16 size)
+{
+    list->data = buffer;
+    list->size = size;
+    list->length = 0;
+    list->full = FALSE;
+
+    Ctx->recording = list;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_EndRecord()
+ * Function           :  Stop recording drawing calls;  subsequent calls are drawn.
+ * Input              :  --
+ * Return             :  TRUE if all calls were recorded;  FALSE if the list is full,
+ *                       i.e. the calls after the first which did not fit were lost.
+------------------------------------------------------------------------------------*/
+bool  LCD_EndRecord(void)
+{
+    bool    complete = (Ctx->recording != NULL && !Ctx->recording->full);
+
+    Ctx->recording = NULL;
+#ifdef LCD_PAGE_MODE
+    LCD_RecordState();   // settings changed while recording apply to later screen calls
+#endif
+    return  complete;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_Replay()
+ *
+ * Function           :  Draw the calls recorded in a display list on the current target
+ *                       (screen or surface), moved by (dx, dy) pixels.  Calls are made
+ *                       in the order recorded, with the same settings, so the pixel
+ *                       mode, font and clip rectangle are left as the last call set them.
+ *                       Calls which do not touch any row of the target are skipped.
+ *
+ * Input              :  list = pointer to display list recorded by LCD_BeginRecord()
+ *                       dx, dy = distance to move recorded positions right and down
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_Replay(displist_t *list, int16 dx, int16 dy)
+{
+    LCD_ReplayList(list->data, list->length, dx, dy);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_InitContext()
+ *
+ * Function           :  Initialise a display context, e.g. for a second LCD module, or to
+ *                       render a screen which is not shown (driver NULL).  The context
+ *                       has its own screen buffer, target, cursor, pixel mode, font, clip
+ *                       rectangle, region pool, batch and recording state;  it is in the
+ *                       same state as the default context after LCD_ClearScreen().
+ *                       The screen is not cleared, nor is the context selected.
+ *
+ * Input              :  ctx = pointer to context struct (not in use)
+ *                       driver = LCD module driver functions;  NULL if none
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_InitContext(lcdcontext_t *ctx, const lcddriver_t *driver)
+{
+    memset(ctx, 0, sizeof(lcdcontext_t));
+    ctx->driver = driver;
+
+    ctx->screen.width = LCD_WIDTH;
+    ctx->screen.height = LCD_HEIGHT;
+#ifdef LCD_PAGE_MODE
+    ctx->screen.stride = LCD_WIDTH;
+    ctx->screen.bits = NULL;             // no buffer -- drawing calls are recorded
+    ctx->strip.width = LCD_WIDTH;
+    ctx->strip.height = 8;
+    ctx->strip.stride = LCD_WIDTH;
+    ctx->strip.bits = ctx->stripBuffer;
+    ctx->screenList.data = ctx->screenListData;
+    ctx->screenList.size = LCD_DISPLAY_LIST_SIZE;
+#elif defined LCD_BUFFER_PAGE_MAJOR
+    ctx->screen.stride = LCD_WIDTH;
+    ctx->screen.bits = ctx->screenBuffer;
+#else
+    ctx->screen.stride = SCN_ROW_WORDS;
+    ctx->screen.bits = ctx->screenBuffer;
+#endif
+    ctx->target = &ctx->screen;
+    ctx->clipRight = LCD_WIDTH;
+    ctx->clipBottom = LCD_HEIGHT;
+    ctx->pixelMode = SET_PIXELS;
+    ctx->fontSize = 8;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_SelectContext()
+ *
+ * Function           :  Select the display context on which all API functions act.
+ *                       An interrupt handler which draws must select its own context
+ *                       on entry and re-select the previous context before returning.
+ *
+ * Input              :  ctx = pointer to context initialised by LCD_InitContext();
+ *                             NULL selects the default context (LCD module driver)
+ * Return             :  pointer to the context selected previously
+------------------------------------------------------------------------------------*/
+lcdcontext_t  *LCD_SelectContext(lcdcontext_t *ctx)
+{
+    lcdcontext_t  *previous = Ctx;
+
+    Ctx = (ctx != NULL) ? ctx : &DefaultContext;
+    return  previous;
+}
+
+
+#ifdef LCD_ROTATION
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_SetRotation()
+ *
+ * Function           :  Set the orientation of the screen on the panel, e.g. to mount
+ *                       the display in portrait orientation.  Drawing functions work in
+ *                       screen (logical) coordinates;  the screen buffer is rotated onto
+ *                       the panel in blocks of 8 x 8 pixels as it is written to GDRAM,
+ *                       so a rotated screen takes little more time to update than an
+ *                       upright one.  Rotated 90 or 270 degrees, the screen is
+ *                       LCD_HEIGHT x LCD_WIDTH pixels (see LCD_GetMaxX, LCD_GetMaxY).
+ *                       The screen is cleared (see LCD_ClearScreen) and the clip
+ *                       rectangle reset, if drawing on screen.
+ *
+ * Input              :  rotation = ROTATE_0, ROTATE_90, ROTATE_180 or ROTATE_270
+ *                                  (clockwise)
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void  LCD_SetRotation(uint8 rotation)
+{
+    Ctx->rotation = rotation & 3;
+
+    if (Ctx->rotation == ROTATE_90 || Ctx->rotation == ROTATE_270)
+    {
+        Ctx->screen.width = LCD_HEIGHT;
+        Ctx->screen.height = LCD_WIDTH;
+    }
+    else
+    {
+        Ctx->screen.width = LCD_WIDTH;
+        Ctx->screen.height = LCD_HEIGHT;
+    }
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    Ctx->screen.stride = Ctx->screen.width;
+#else
+    Ctx->screen.stride = (Ctx->screen.width + SCN_WORD_BITS - 1) / SCN_WORD_BITS;
+#endif
+
+    if (Ctx->target == &Ctx->screen)
+    {
+        Ctx->clipLeft = 0;
+        Ctx->clipTop = 0;
+        Ctx->clipRight = Ctx->screen.width;
+        Ctx->clipBottom = Ctx->screen.height;
+    }
+
+    LCD_ClearScreen();
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_GetRotation()
+ * Function           :  Returns the orientation of the screen set by LCD_SetRotation()
+ * Return             :  ROTATE_0, ROTATE_90, ROTATE_180 or ROTATE_270
+------------------------------------------------------------------------------------*/
+uint8  LCD_GetRotation(void)
+{
+    return Ctx->rotation;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_GetMaxX(), LCD_GetMaxY()
+ * Function           :  Returns the greatest x or y coord on screen, in the orientation
+ *                       set by LCD_SetRotation(), i.e. screen width or height - 1.
+------------------------------------------------------------------------------------*/
+int16  LCD_GetMaxX(void)
+{
+    return Ctx->screen.width - 1;
+}
+
+int16  LCD_GetMaxY(void)
+{
+    return Ctx->screen.height - 1;
+}
+#endif  // LCD_ROTATION
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_SetFont()
+ * Function           :  Set font style for text display using functions...
+ *                       LCD_PutChar(), LCD_PutText(), etc.
+ *
+ * Input              :  uint8  font_ID = one of the following...
+ * 
+ *    MONO_8_NORM      Mono-spaced font;  char width is 5 pix
+ *    PROP_8_NORM      Proportional font;  char width is 3..5 pix
+ *    PROP_12_NORM     Proportional font;  char width is 4..7 pix
+ *    PROP_12_BOLD     as above, but bold weight (width + 1)
+ *    MONO_16_NORM     Mono-spaced font;  char width is 10 pix
+ *    MONO_16_BOLD     as above, but bold weight (width + 1)
+ *    PROP_24_NORM     Proportional font;  char width is 7..15 pix
+ * 
+------------------------------------------------------------------------------------*/
+void   LCD_SetFont(uint8 font_ID)
+{
+    Ctx->fontWeight = font_ID & 1;            // b0 (0: normal, 1: bold)
+    Ctx->fontProp = (font_ID >> 1) & 1;       // b1 (0: monospaced, 1: proportional)
+    Ctx->fontSize = 8 + 4 * (font_ID >> 2);   // b3:b2 (0: 8p, 1: 12p, 2: 16p, 3: 24p)
+    if (font_ID >= 12) Ctx->fontSize = 24;    // corrected
+
+    LCD_RecordSetting(DL_FONT, font_ID);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_GetFont()
+ * Function           :  Get current font ID setting
+ *
+ * Input              :  --
+ * Return             :  uint8  font_ID = 0 .. 15
+------------------------------------------------------------------------------------*/
+uint8  LCD_GetFont()
+{
+    uint8  size_id = (Ctx->fontSize - 8) / 4;   // 0, 1, 2, 4
+
+    if (size_id == 4) size_id = 3;  // corrected
+
+    return  (size_id << 2) + (Ctx->fontProp << 1) + Ctx->fontWeight;
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_PutChar()
+ * Function           :  Show ASCII char at current (x, y) using selected font.
+ * Input              :  (uint8) uc = ASCII char to be displayed
+ * Return             :  --
+------------------------------------------------------------------------------------*/
+void   LCD_PutChar(char uc)
+{
+    LCD_RecordText(&uc, 1);
+    LCD_DrawChar(uc);
+}
+
+
+/*----------------------------------------------------------------------------------
+ * Name               :  LCD_PutText()
  * Function           :  Show text string at (x, y) using selected font.
  *                       Stops at first non-printable char found (e.g. NUL).
- *                       Truncates text beyond the right boundary of the screen
- *                       if the string is too long to fit on the current line.
+ *                       Truncates text beyond the right boundary of the screen,
+ *                       or of the clip rectangle, if the string is too long to fit
+ *                       on the current line.
  *
  * Input              :  str = pointer to ASCII string (NUL terminated)
  * Return             :  --
 ------------------------------------------------------------------------------------*/
 void   LCD_PutText(char *str)
 {
-    uint8  b;
+    int    count;
+    int16  nextX = Ctx->cursorPosX;     // X coord of next piece of string
+    int16  endX;
 
-    while ((b = *str) >= 0x20)
+    while ((uint8) *str >= 0x20 && (nextX < Ctx->clipRight || Ctx->recording != NULL))
     {
-        LCD_PutChar(b);
-        str++;
+        // Show the string in pieces of up to 255 chars (the most a display list holds)
+        for (count = 1;  count < 255 && (uint8) str[count] >= 0x20;  count++)  { }
+        endX = Ctx->cursorPosX;
+        Ctx->cursorPosX = nextX;
+        nextX = LCD_ShowText(str, count);
+        if (endX >= Ctx->clipRight)  Ctx->cursorPosX = endX;   // stopped -- piece only recorded
+        str += count;
     }
 }
 
@@ -862,84 +1905,283 @@ void  LCD_PutDecimalWord(uint16 uwVal, uint8 bFieldSize)
 //==============================  Private functions  =====================================
 
 /*----------------------------------------------------------------------------------------
- * Name               :  LCD_PutChar8()
- *
- * Function           :  Display character from 5 x 8 font in normal size (5 x 8 pixels)
- *                       at current cursor position.
- *                       On return, CursorPosX is advanced (6 pixels if mono-spaced)
- *
- * Input              :  uint8 uc = ASCII char code
+ * Name               :  LCD_DrawChar()
+ * Function           :  Show ASCII char at current (x, y) using selected font.
+ *                       Same as LCD_PutChar(), but the call is not recorded.
+ * Input              :  (uint8) uc = ASCII char to be displayed
  * Return             :  --
  *--------------------------------------------------------------------------------------*/
-PRIVATE  void  LCD_PutChar8(uint8 uc)
+PRIVATE  void   LCD_DrawChar(uint8 uc)
 {
-    short   i;
-    uint8   bitmap[10];  // char cell buffer
-    uint8  *pData;
-    uint8   width;       // symbol width (pixels)
-    bool    descender;   // True => shift bitmap down 1 pixel in cell
-
-    if (uc < 32) return;  // non-printable
-
-    if (FontProp)  // proportional width font
-    {
-        pData = (uint8 *) &font_table_prop_5x8[(uc - 32) * 8];  // use prop'l table!
+    if (Ctx->fontSize >= 24)  LCD_PutChar24(uc);
+    else if (Ctx->fontSize >= 16)  LCD_PutChar16(uc);
+    else if (Ctx->fontSize >= 12)  LCD_PutChar12(uc);
+    else  LCD_PutChar8(uc);
+}
 
-        width = *pData & 0x0F;
-        descender = *pData & 0x80;
-        pData++;
-        bitmap[7] = 0x00;  // clear bottom row
 
-        for (i = 0;  i < 7;  i++, pData++)  // copy from table to cell buffer
-        {
-            if (descender) bitmap[i+1] = *pData;  // shift down a row
-            else  bitmap[i] = *pData;
-        }
-        // special cases -- top row
-        if (descender) bitmap[0] = 0x00;  // top row is blank
-        // special cases -- bottom row
-        if (uc == 'j') bitmap[7] = 0x80;  // .. 'j' has a hook
-        else if (uc == '[') bitmap[7] = 0xC0;
-        else if (uc == ']') bitmap[7] = 0x60;
-        else if (uc == '{' ) bitmap[7] = 0x30;
-        else if (uc == '}' ) bitmap[7] = 0xC0;
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ShowText()
+ *
+ * Function           :  Show a number of chars at current (x, y) using selected font,
+ *                       as one recorded call.  Stops at the RH edge of the clip rectangle,
+ *                       leaving the cursor after the last char shown.  Only the chars
+ *                       shown are recorded in the screen list;  in a user list, all the
+ *                       chars are recorded, as they may come into view when the list is
+ *                       replayed moved, or on a wider target.
+ *                       In page mode, the pages covered by the text are rendered once,
+ *                       after the last char.
+ *
+ * Input              :  str = pointer to chars;  count = number of chars (1..255)
+ * Return             :  X coord following the last char recorded
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  int16  LCD_ShowText(char *str, int count)
+{
+    int     i;
+    int16   startX = Ctx->cursorPosX;
+    int16   endX;
+    int16   nextX;
+#ifdef LCD_PAGE_MODE
+    bool    batch = Ctx->batchMode;
 
-        LCD_PutImage(bitmap, 5, 8);
-        CursorPosX += width + 1;
+    if (Ctx->target == &Ctx->screen)  Ctx->batchMode = TRUE;   // defer rendering to end of text
+#endif
+    for (i = 0;  i < count && Ctx->cursorPosX < Ctx->clipRight;  i++)
+    {
+        LCD_DrawChar(str[i]);
     }
-    else  // mono-spaced font
+    endX = Ctx->cursorPosX;
+
+    // Recording a user list, find the end of the rest of the chars (nothing is drawn)
+    if (Ctx->recording != NULL)
     {
-        pData = (uint8 *) &font_table_mono_5x8[(uc - 32) * 8];  // use mono table!
+        for ( ;  i < count;  i++)  LCD_DrawChar(str[i]);
+    }
 
-        for (i = 0;  i < 8;  i++, pData++)
-        {
-            bitmap[i] = *pData;
-        }
+    // Record the chars from the start position (cursor advanced as drawn)
+    nextX = Ctx->cursorPosX;
+    Ctx->cursorPosX = startX;
+    LCD_RecordText(str, i);
+    Ctx->cursorPosX = endX;
 
-        LCD_PutImage(bitmap, 6, 8);
-        CursorPosX += 6;
-    }
+#ifdef LCD_PAGE_MODE
+    if (!batch && Ctx->target == &Ctx->screen)  LCD_Flush();
+#endif
+    return  nextX;
 }
 
 
 /*----------------------------------------------------------------------------------------
- * Name               :  LCD_PutChar16()
+ * Name               :  LCD_SetClipRect()
  *
- * Function           :  Display character in size 16 font... Char-cell 12 x 16 pix.
- *                       On return, PosX is advanced 12 pixels.
+ * Function           :  Set the clip rectangle to the intersection of the block (w x h)
+ *                       at (x, y) with the target, and record the call.  The block may
+ *                       extend beyond any edge of the target, e.g. when a screen clip
+ *                       rectangle is replayed on one page of the screen.
  *
- * Input              :  uint8 uc = (ext'd) ASCII char code
+ * Input              :  x, y = pixel coords of upper LHS of block (may be negative)
+ *                       w, h = width and height of block, pixels
  * Return             :  --
  *--------------------------------------------------------------------------------------*/
-PRIVATE  void   LCD_PutChar16(uint8 uc)
+PRIVATE  void  LCD_SetClipRect(int x, int y, int w, int h)
 {
-    if (uc < 32) return;  // non-printable
+    displist_t  *list = LCD_GetRecorder(TRUE);
 
-    if (uc >= '0' && uc <= '9') LCD_PutChar16_smooth(uc);  // digit 0 ~ 9
-    else  LCD_PutChar16_ruff(uc);    // all other symbols
+    if (list != NULL && LCD_ListBegin(list, DL_CLIP, 9))
+    {
+        LCD_ListPut16(list, x);
+        LCD_ListPut16(list, y);
+        LCD_ListPut16(list, w);
+        LCD_ListPut16(list, h);
+    }
 
-    CursorPosX += 12;
-    if (FontWeight) CursorPosX++;  // bold
+    Ctx->clipLeft = (x < 0) ? 0 : (x < Ctx->target->width) ? x : Ctx->target->width;
+    Ctx->clipTop = (y < 0) ? 0 : (y < Ctx->target->height) ? y : Ctx->target->height;
+    Ctx->clipRight = ((x + w) < Ctx->target->width) ? (x + w) : Ctx->target->width;
+    Ctx->clipBottom = ((y + h) < Ctx->target->height) ? (y + h) : Ctx->target->height;
+    if (Ctx->clipRight < Ctx->clipLeft)  Ctx->clipRight = Ctx->clipLeft;      // empty
+    if (Ctx->clipBottom < Ctx->clipTop)  Ctx->clipBottom = Ctx->clipTop;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ClipBlock()
+ *
+ * Function           :  Clip a block to the clip rectangle.  On return, (x, y) and (w, h)
+ *                       give the position and size of the visible part of the block, and
+ *                       (sx, sy) give its offset from the upper LHS of the whole block,
+ *                       e.g. the first image column and row to be drawn.
+ *
+ * Input              :  x, y = pointers to pixel coords of upper LHS of block
+ *                       w, h = pointers to width and height of block, pixels
+ * Output             :  sx, sy = offset of visible part within block, pixels
+ *
+ * Return             :  TRUE if any part of the block is visible;  else FALSE
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  bool  LCD_ClipBlock(int *x, int *y, int *w, int *h, int *sx, int *sy)
+{
+    int     left = *x;
+    int     top = *y;
+    int     right = *x + *w;
+    int     bottom = *y + *h;
+
+    if (left < Ctx->clipLeft)  left = Ctx->clipLeft;
+    if (top < Ctx->clipTop)  top = Ctx->clipTop;
+    if (right > Ctx->clipRight)  right = Ctx->clipRight;
+    if (bottom > Ctx->clipBottom)  bottom = Ctx->clipBottom;
+    if (left >= right || top >= bottom)  return FALSE;
+
+    *sx = left - *x;
+    *sy = top - *y;
+    *x = left;
+    *y = top;
+    *w = right - left;
+    *h = bottom - top;
+
+    return TRUE;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_UpdateBlock()
+ *
+ * Function           :  Update LCD module GDRAM after a block (w x h pixels) of the screen
+ *                       buffer at (x, y) has been modified.  In batch mode, the tiles
+ *                       covered by the block are flagged as dirty, to be written by
+ *                       LCD_Flush(), otherwise the block is written to the LCD module
+ *                       immediately.  In page mode, the pages covered by the block are
+ *                       rendered from the display list and written;  likewise, if the
+ *                       screen is rotated, from the rotated screen buffer.
+ *
+ * Input              :  x, y = pixel coords of upper LHS of block (on screen)
+ *                       w, h = width and height (pixels) of block, x + w <= screen width
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_UpdateBlock(int x, int y, int w, int h)
+{
+    int     page, lastPage;
+    int     firstCol, lastCol;
+    uint64  dirtyCols;              // tile flags for cols firstCol..lastCol in page 0
+
+    if (Ctx->target != &Ctx->screen)  return;     // drawing off-screen
+    if (Ctx->driver == NULL)  return;             // screen not shown
+    if (w <= 0 || h <= 0)  return;                // nothing on screen
+#ifdef LCD_ROTATION
+    if (Ctx->rotation != ROTATE_0)  LCD_RotateBlock(&x, &y, &w, &h);   // to panel coords
+#endif
+    if (y >= LCD_HEIGHT)  return;
+    if ((y + h) > LCD_HEIGHT)  h = LCD_HEIGHT - y;
+
+    Ctx->panelBlank = FALSE;   // written now, or at the next flush
+
+    if (!Ctx->batchMode)
+    {
+#ifdef LCD_PAGE_MODE
+        for (page = y / 8;  page <= (y + h - 1) / 8;  page++)  LCD_RenderPage(page);
+#else
+#ifdef LCD_ROTATION
+        if (Ctx->rotation != ROTATE_0)
+        {
+            for (page = y / 8;  page <= (y + h - 1) / 8;  page++)  LCD_RenderRotatedPage(page);
+            return;
+        }
+#endif
+        Ctx->driver->writeBlock(Ctx->screenBuffer, x, y, w, h);
+#endif
+        return;
+    }
+
+    firstCol = x / LCD_TILE_WIDTH;
+    lastCol = (x + w - 1) / LCD_TILE_WIDTH;
+    lastPage = (y + h - 1) / 8;
+    dirtyCols = ((uint64) 2 << lastCol) - ((uint64) 1 << firstCol);
+
+    for (page = y / 8;  page <= lastPage;  page++)
+    {
+        Ctx->dirtyTiles |= dirtyCols << (page * LCD_TILE_COLS);
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutChar8()
+ *
+ * Function           :  Display character from 5 x 8 font in normal size (5 x 8 pixels)
+ *                       at current cursor position.
+ *                       On return, the cursor X-coord is advanced (6 pixels if mono-spaced)
+ *
+ * Input              :  uint8 uc = ASCII char code
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_PutChar8(uint8 uc)
+{
+    short   i;
+    uint8   bitmap[10];  // char cell buffer
+    uint8  *pData;
+    uint8   width;       // symbol width (pixels)
+    bool    descender;   // True => shift bitmap down 1 pixel in cell
+
+    if (uc < 32) return;  // non-printable
+
+    if (Ctx->fontProp)  // proportional width font
+    {
+        pData = (uint8 *) &font_table_prop_5x8[(uc - 32) * 8];  // use prop'l table!
+
+        width = *pData & 0x0F;
+        descender = *pData & 0x80;
+        pData++;
+        bitmap[7] = 0x00;  // clear bottom row
+
+        for (i = 0;  i < 7;  i++, pData++)  // copy from table to cell buffer
+        {
+            if (descender) bitmap[i+1] = *pData;  // shift down a row
+            else  bitmap[i] = *pData;
+        }
+        // special cases -- top row
+        if (descender) bitmap[0] = 0x00;  // top row is blank
+        // special cases -- bottom row
+        if (uc == 'j') bitmap[7] = 0x80;  // .. 'j' has a hook
+        else if (uc == '[') bitmap[7] = 0xC0;
+        else if (uc == ']') bitmap[7] = 0x60;
+        else if (uc == '{' ) bitmap[7] = 0x30;
+        else if (uc == '}' ) bitmap[7] = 0xC0;
+
+        LCD_BlitImage(bitmap, NULL, 5, 8, FALSE);
+        Ctx->cursorPosX += width + 1;
+    }
+    else  // mono-spaced font
+    {
+        pData = (uint8 *) &font_table_mono_5x8[(uc - 32) * 8];  // use mono table!
+
+        for (i = 0;  i < 8;  i++, pData++)
+        {
+            bitmap[i] = *pData;
+        }
+
+        LCD_BlitImage(bitmap, NULL, 6, 8, FALSE);
+        Ctx->cursorPosX += 6;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutChar16()
+ *
+ * Function           :  Display character in size 16 font... Char-cell 12 x 16 pix.
+ *                       On return, PosX is advanced 12 pixels.
+ *
+ * Input              :  uint8 uc = (ext'd) ASCII char code
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void   LCD_PutChar16(uint8 uc)
+{
+    if (uc < 32) return;  // non-printable
+
+    if (uc >= '0' && uc <= '9') LCD_PutChar16_smooth(uc);  // digit 0 ~ 9
+    else  LCD_PutChar16_ruff(uc);    // all other symbols
+
+    Ctx->cursorPosX += 12;
+    if (Ctx->fontWeight) Ctx->cursorPosX++;  // bold
 }
 
 
@@ -989,7 +2231,7 @@ PRIVATE  void   LCD_PutChar16_ruff(uint8 uc)
         }
 
         // Apply bold typeface if requested...
-        if (FontWeight >= 1 && allow_bold)
+        if (Ctx->fontWeight >= 1 && allow_bold)
         {
             shifted = pixels >> 1;
             pixels |= shifted;
@@ -1004,7 +2246,7 @@ PRIVATE  void   LCD_PutChar16_ruff(uint8 uc)
         k++;
     }
 
-    LCD_PutImage((uint8 *) bitmap, 12, 16);
+    LCD_BlitImage((uint8 *) bitmap, NULL, 12, 16, FALSE);
 }
 
 
@@ -1024,7 +2266,7 @@ PRIVATE  void   LCD_PutChar16_smooth(uint8 uc)
 
     bitmap = (uint8 *) &font_table_digit_10x16[(uc - '0') * 32];
 
-    LCD_PutImage(bitmap, 12, 16);
+    LCD_BlitImage(bitmap, NULL, 12, 16, FALSE);
 }
 
 
@@ -1070,13 +2312,13 @@ PRIVATE  void  LCD_PutChar12(uint8 uc)
         {
             bitmap[i+2] = *pData;
             shifted = *pData >> 1;
-            if (FontWeight > 0 && allowBold)  bitmap[i+2] |= shifted;  // make bold
+            if (Ctx->fontWeight > 0 && allowBold)  bitmap[i+2] |= shifted;  // make bold
         }
         else  // regular symbol -- no descender -- 
         {
             bitmap[i] = *pData;
             shifted = *pData >> 1;
-            if (FontWeight > 0 && allowBold)  bitmap[i] |= shifted;  // make bold
+            if (Ctx->fontWeight > 0 && allowBold)  bitmap[i] |= shifted;  // make bold
         }
     }
     
@@ -1085,9 +2327,9 @@ PRIVATE  void  LCD_PutChar12(uint8 uc)
     if (uc == '[' || uc == ']' || uc == '|' || uc == '{' || uc == '}' )  
         bitmap[10] = bitmap[0];
  
-    LCD_PutImage(bitmap, 8, 12);
-    CursorPosX += width + 2;
-    if (FontWeight > 0) CursorPosX++;
+    LCD_BlitImage(bitmap, NULL, 8, 12, FALSE);
+    Ctx->cursorPosX += width + 2;
+    if (Ctx->fontWeight > 0) Ctx->cursorPosX++;
 }
 
 
@@ -1172,8 +2414,2112 @@ PRIVATE  void  LCD_PutChar24(uint8 uc)
         bitmap[21][1] = bitmap[20][1] = bitmap[0][1];
     }
 
-    LCD_PutImage((uint8 *) bitmap, 16, 24);
-    CursorPosX += (width * 2) + 3;
+    LCD_BlitImage((uint8 *) bitmap, NULL, 16, 24, FALSE);
+    Ctx->cursorPosX += (width * 2) + 3;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RasterOp()
+ *
+ * Function           :  Modify pixels in a buffer word (column-word or page byte) using
+ *                       the given writing mode.  Expanded in line, with constant mode,
+ *                       by the kernel worker functions.
+ *
+ * Input              :  pWord = pointer to buffer word
+ *                       pixels = source pixels (0 outside of bitmask)
+ *                       bitmask = pixels in word covered by the source (1 = covered);
+ *                                 only used by the COPY and AND modes
+ *                       mode = pixel writing mode (constant), or TEST_PIXELS (no change)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_RasterOp(scnword_t *pWord, scnword_t pixels, scnword_t bitmask, uint8 mode)
+{
+    if (mode == SET_PIXELS)  *pWord |= pixels;
+    else if (mode == CLEAR_PIXELS)  *pWord &= ~pixels;
+    else if (mode == FLIP_PIXELS)  *pWord ^= pixels;
+    else if (mode == COPY_PIXELS)  *pWord = (*pWord & ~bitmask) | pixels;
+    else if (mode == AND_PIXELS)  *pWord &= pixels | ~bitmask;
+    // else TEST_PIXELS -- buffer unchanged
+}
+
+
+#ifndef LCD_BUFFER_PAGE_MAJOR
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FillRows()
+ *
+ * Function           :  Row-major buffer kernel for LCD_BlockFill().
+ *                       Fills a block of w x h pixels at (x, y) using the global
+ *                       writing mode.  The pixels to be modified in the first and last
+ *                       column-words of each row are found by a single shift each,
+ *                       so the time taken depends only on the number of words touched.
+ *                       The writing mode is tested once, to select a specialised loop.
+ *
+ * Input              :  dst = surface to be modified
+ *                       x, y = pixel coords of upper LHS of block (x + w <= dst width)
+ *                       w, h = width and height (pixels) of block
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_FillRows(surface_t *dst, int x, int y, int w, int h)
+{
+    if (y >= dst->height || w <= 0 || h <= 0)  return;
+    if ((y + h) > dst->height)  h = dst->height - y;
+
+    switch (Ctx->pixelMode)
+    {
+    case SET_PIXELS:    // COPY of a solid block is the same as SET
+    case COPY_PIXELS:   LCD_FillRowsOp(dst, x, y, w, h, SET_PIXELS);  break;
+    case CLEAR_PIXELS:  LCD_FillRowsOp(dst, x, y, w, h, CLEAR_PIXELS);  break;
+    case FLIP_PIXELS:   LCD_FillRowsOp(dst, x, y, w, h, FLIP_PIXELS);  break;
+    default:            break;  // AND_PIXELS -- AND with a solid block has no effect
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FillRowsOp()
+ *
+ * Function           :  Worker for LCD_FillRows(), expanded in line for each writing mode.
+ *
+ * Input              :  dst, x, y, w, h = block (clipped to surface, w > 0, h > 0)
+ *                       mode = pixel writing mode (constant)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_FillRowsOp(surface_t *dst, int x, int y, int w, int h, uint8 mode)
+{
+    int     row, col;               // row and column word index for screen buffer
+    scnword_t  *pRow;               // first word of row in surface
+    int     firstCol;               // first (leftmost) column-word in a row to be modified
+    int     lastCol;                // last (rightmost) column-word in a row to be modified
+    scnword_t  leftMask;            // pixels to be modified in first column-word
+    scnword_t  rightMask;           // pixels to be modified in last column-word
+
+    firstCol = x / SCN_WORD_BITS;
+    lastCol = (x + w - 1) / SCN_WORD_BITS;
+    leftMask = SCN_WORD_ONES >> (x % SCN_WORD_BITS);
+    rightMask = SCN_WORD_ONES << (SCN_WORD_BITS - 1 - (x + w - 1) % SCN_WORD_BITS);
+
+    if (firstCol == lastCol)  leftMask &= rightMask;   // block within one word
+
+    for (row = y;  row < (y + h);  row++)
+    {
+        pRow = dst->bits + row * dst->stride;
+        LCD_RasterOp(&pRow[firstCol], leftMask, leftMask, mode);
+        if (firstCol == lastCol)  continue;
+
+        for (col = firstCol + 1;  col < lastCol;  col++)
+        {
+            LCD_RasterOp(&pRow[col], SCN_WORD_ONES, SCN_WORD_ONES, mode);
+        }
+        LCD_RasterOp(&pRow[lastCol], rightMask, rightMask, mode);
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutImageRows()
+ *
+ * Function           :  Row-major buffer kernel for LCD_PutImage().
+ *                       Each column-word of a row is formed from two adjacent words of
+ *                       image data by a single shift-and-merge, then written to the
+ *                       buffer using the global writing mode.  Where x is a multiple of
+ *                       8, the image bytes fall on buffer byte boundaries and the
+ *                       shift-and-merge is skipped.
+ *                       If a mask is given, the image is copied to the buffer where the
+ *                       mask pixels are set, and the buffer is unchanged elsewhere.
+ *
+ * Input              :  dst = surface to be modified
+ *                       imageData = pointer to bit-map image data (see LCD_PutImage)
+ *                       maskData = pointer to mask bit-map, same format, or NULL
+ *                       x, y = pixel coords of upper LHS of image (x + w <= dst width)
+ *                       w, h = image width (clipped) and height, pixels
+ *                       bytesInRow = number of bytes per image row in imageData
+ *                       sx = image column drawn at x (> 0 if clipped on the left)
+ *                       info = collision report to be added to (see LCD_GetCollision),
+ *                              or NULL if image pixels are not tested against buffer
+ *
+ * Return             :  TRUE (1) if any image pixel collides with a pixel already set
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  uint8  LCD_PutImageRows(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                 int x, int y, int w, int h, int bytesInRow, int sx,
+                                 collision_t *info)
+{
+    uint8   mode = Ctx->pixelMode;
+
+    if (y >= dst->height || w <= 0 || h <= 0)  return 0;
+    if ((y + h) > dst->height)  h = dst->height - y;
+
+    if (maskData != NULL)
+    {
+        if (info != NULL)
+            return LCD_PutImageRowsOp(dst, imageData, maskData, x, y, w, h,
+                                      bytesInRow, sx, COPY_PIXELS, TRUE, info);
+        return LCD_PutImageRowsOp(dst, imageData, maskData, x, y, w, h,
+                                  bytesInRow, sx, COPY_PIXELS, FALSE, NULL);
+    }
+
+    if (info != NULL)
+    {
+        switch (mode)
+        {
+        case SET_PIXELS:    return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                      bytesInRow, sx, SET_PIXELS, TRUE, info);
+        case CLEAR_PIXELS:  return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                      bytesInRow, sx, CLEAR_PIXELS, TRUE, info);
+        case FLIP_PIXELS:   return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                      bytesInRow, sx, FLIP_PIXELS, TRUE, info);
+        case COPY_PIXELS:   return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                      bytesInRow, sx, COPY_PIXELS, TRUE, info);
+        default:            return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                      bytesInRow, sx, AND_PIXELS, TRUE, info);
+        }
+    }
+
+    switch (mode)
+    {
+    case SET_PIXELS:    return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                  bytesInRow, sx, SET_PIXELS, FALSE, NULL);
+    case CLEAR_PIXELS:  return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                  bytesInRow, sx, CLEAR_PIXELS, FALSE, NULL);
+    case FLIP_PIXELS:   return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                  bytesInRow, sx, FLIP_PIXELS, FALSE, NULL);
+    case COPY_PIXELS:   return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                  bytesInRow, sx, COPY_PIXELS, FALSE, NULL);
+    default:            return LCD_PutImageRowsOp(dst, imageData, NULL, x, y, w, h,
+                                                  bytesInRow, sx, AND_PIXELS, FALSE, NULL);
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutImageRowsOp()
+ *
+ * Function           :  Worker for LCD_PutImageRows(), expanded in line for each
+ *                       writing mode, with and without the collision test.
+ *
+ * Input              :  dst, imageData, maskData, x, y, w, h, bytesInRow, sx =
+ *                       see LCD_PutImageRows()  (image clipped to surface, w > 0, h > 0)
+ *                       mode = pixel writing mode (constant);  TEST_PIXELS to return
+ *                              on the first collision, without modifying the buffer
+ *                       checkCollision = TRUE to test for collision (constant)
+ *                       info = collision report (if checkCollision, and not TEST_PIXELS)
+ *
+ * Return             :  TRUE (1) if any image pixel collides with a pixel already set
+ *--------------------------------------------------------------------------------------*/
+INLINE  uint8  LCD_PutImageRowsOp(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                  int x, int y, int w, int h, int bytesInRow, int sx,
+                                  uint8 mode, bool checkCollision, collision_t *info)
+{
+    int     row, col;               // row and column word index for screen buffer
+    scnword_t  *pRow;               // first word of row in surface
+    int     firstCol;               // first (leftmost) column-word in a row to be modified
+    int     lastCol;                // last (rightmost) column-word in a row to be modified
+    int     originX;                // buffer x-coord of image column 0 (may be < 0)
+    int     byteIndex;              // index of first image byte in column-word
+    int     shift;                  // bit offset of image from byte boundary (0..7)
+    scnword_t  leftMask;            // pixels to be modified in first column-word
+    scnword_t  rightMask;           // pixels to be modified in last column-word
+    scnword_t  imageWord;           // image bytes which fall in column-word
+    scnword_t  prevWord;            // image bytes which fall in previous column-word
+    scnword_t  pixelWord;           // image pixels aligned to column-word
+    scnword_t  maskWord, prevMask;  // the same, for mask bit-map
+    scnword_t  bitmask;             // pixels in column-word covered by image
+    uint32  overlap;                // image pixels which fall on pixels already set
+    uint8   *pData, *pMask;
+    uint8   collision = 0;
+
+    firstCol = x / SCN_WORD_BITS;
+    lastCol = (x + w - 1) / SCN_WORD_BITS;
+    leftMask = SCN_WORD_ONES >> (x % SCN_WORD_BITS);
+    rightMask = SCN_WORD_ONES << (SCN_WORD_BITS - 1 - (x + w - 1) % SCN_WORD_BITS);
+    originX = x - sx;
+    shift = originX & 7;    // (originX modulo 8, also if negative)
+
+    for (row = y;  row < (y + h);  row++)
+    {
+        pRow = dst->bits + row * dst->stride;
+        pData = imageData + (row - y) * bytesInRow;
+        pMask = maskData + (row - y) * bytesInRow;
+        byteIndex = (firstCol * SCN_WORD_BITS - originX + shift) / 8;  // may be < 0
+        prevWord = 0;
+        prevMask = 0;
+        if (sx > 0 && shift != 0)   // image clipped on the left -- get bytes before
+        {
+            prevWord = LCD_GetImageWord(pData, byteIndex - SCN_WORD_BITS / 8, bytesInRow);
+            if (maskData != NULL)
+                prevMask = LCD_GetImageWord(pMask, byteIndex - SCN_WORD_BITS / 8, bytesInRow);
+        }
+
+        for (col = firstCol;  col <= lastCol;  col++, byteIndex += SCN_WORD_BITS / 8)
+        {
+            imageWord = LCD_GetImageWord(pData, byteIndex, bytesInRow);
+
+            if (shift == 0)  pixelWord = imageWord;   // byte-aligned
+            else  pixelWord = (imageWord >> shift) | (prevWord << (SCN_WORD_BITS - shift));
+            prevWord = imageWord;
+
+            bitmask = SCN_WORD_ONES;
+            if (col == firstCol)  bitmask = leftMask;
+            if (col == lastCol)  bitmask &= rightMask;   // mask off "out of bounds" pixels
+
+            if (maskData != NULL)  // apply mask bit-map
+            {
+                maskWord = LCD_GetImageWord(pMask, byteIndex, bytesInRow);
+                if (shift == 0)  bitmask &= maskWord;
+                else  bitmask &= (maskWord >> shift) | (prevMask << (SCN_WORD_BITS - shift));
+                prevMask = maskWord;
+            }
+            pixelWord &= bitmask;
+
+            if (checkCollision && (pRow[col] & pixelWord))
+            {
+                if (mode == TEST_PIXELS)  return 1;   // nothing to draw -- done
+                collision = 1;
+                overlap = pRow[col] & pixelWord;
+                LCD_AddCollision(info,
+                        col * SCN_WORD_BITS + __builtin_clz(overlap) - (32 - SCN_WORD_BITS),
+                        row, col * SCN_WORD_BITS + SCN_WORD_BITS - __builtin_ctz(overlap),
+                        row + 1, LCD_CountBits(overlap));
+            }
+
+            LCD_RasterOp(&pRow[col], pixelWord, bitmask, mode);
+        }
+    }
+
+    return  collision;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_BlitSurfaceRows()
+ *
+ * Function           :  Row-major buffer kernel for LCD_PutSurface().
+ *                       Each target column-word is formed from two adjacent source words
+ *                       by a single shift-and-merge, then written using the global
+ *                       writing mode.
+ *
+ * Input              :  dst = surface to be modified
+ *                       src = source surface
+ *                       sx, sy = pixel coords of upper LHS of block in source
+ *                       x, y = pixel coords of upper LHS of block in target
+ *                       w, h = width and height of block (clipped to both surfaces)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_BlitSurfaceRows(surface_t *dst, surface_t *src, int sx, int sy,
+                                   int x, int y, int w, int h)
+{
+    if (w <= 0 || h <= 0)  return;
+
+    switch (Ctx->pixelMode)
+    {
+    case SET_PIXELS:    LCD_BlitSurfaceRowsOp(dst, src, sx, sy, x, y, w, h, SET_PIXELS);  break;
+    case CLEAR_PIXELS:  LCD_BlitSurfaceRowsOp(dst, src, sx, sy, x, y, w, h, CLEAR_PIXELS);  break;
+    case FLIP_PIXELS:   LCD_BlitSurfaceRowsOp(dst, src, sx, sy, x, y, w, h, FLIP_PIXELS);  break;
+    case COPY_PIXELS:   LCD_BlitSurfaceRowsOp(dst, src, sx, sy, x, y, w, h, COPY_PIXELS);  break;
+    default:            LCD_BlitSurfaceRowsOp(dst, src, sx, sy, x, y, w, h, AND_PIXELS);  break;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_BlitSurfaceRowsOp()
+ *
+ * Function           :  Worker for LCD_BlitSurfaceRows(), expanded in line for each
+ *                       writing mode.
+ *
+ * Input              :  dst, src, sx, sy, x, y, w, h = see LCD_BlitSurfaceRows()
+ *                       mode = pixel writing mode (constant)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_BlitSurfaceRowsOp(surface_t *dst, surface_t *src, int sx, int sy,
+                                    int x, int y, int w, int h, uint8 mode)
+{
+    int     row, col;               // row index in block, column-word index in target
+    int     firstCol;               // first (leftmost) column-word in a row to be modified
+    int     lastCol;                // last (rightmost) column-word in a row to be modified
+    int     bitIndex;               // source pixel aligned with MS bit of target word
+    scnword_t  leftMask;            // pixels to be modified in first column-word
+    scnword_t  rightMask;           // pixels to be modified in last column-word
+    scnword_t  bitmask;             // pixels in column-word covered by block
+    scnword_t  pixelWord;           // source pixels aligned to column-word
+    scnword_t  *pRow, *pSrc;        // first word of row in target and source
+
+    firstCol = x / SCN_WORD_BITS;
+    lastCol = (x + w - 1) / SCN_WORD_BITS;
+    leftMask = SCN_WORD_ONES >> (x % SCN_WORD_BITS);
+    rightMask = SCN_WORD_ONES << (SCN_WORD_BITS - 1 - (x + w - 1) % SCN_WORD_BITS);
+
+    for (row = 0;  row < h;  row++)
+    {
+        pRow = dst->bits + (y + row) * dst->stride;
+        pSrc = src->bits + (sy + row) * src->stride;
+        bitIndex = sx - (x % SCN_WORD_BITS);
+
+        for (col = firstCol;  col <= lastCol;  col++, bitIndex += SCN_WORD_BITS)
+        {
+            bitmask = SCN_WORD_ONES;
+            if (col == firstCol)  bitmask = leftMask;
+            if (col == lastCol)  bitmask &= rightMask;
+
+            pixelWord = LCD_GetSurfaceWord(pSrc, bitIndex, src->stride) & bitmask;
+
+            LCD_RasterOp(&pRow[col], pixelWord, bitmask, mode);
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_GetSurfaceWord()
+ *
+ * Function           :  Returns SCN_WORD_BITS pixels of a surface row, starting at pixel
+ *                       bitIndex, aligned to a column-word (first pixel in MS bit).
+ *                       Pixels outside the row buffer are read as zero.
+ *
+ * Input              :  rowData = pointer to first word of surface row
+ *                       bitIndex = pixel index of first pixel (may be < 0)
+ *                       wordsInRow = number of column-words per row (stride)
+ *
+ * Return             :  Column-word of surface pixels
+ *--------------------------------------------------------------------------------------*/
+INLINE  scnword_t  LCD_GetSurfaceWord(scnword_t *rowData, int bitIndex, int wordsInRow)
+{
+    int     k;                      // index of word holding first pixel
+    int     shift;                  // bit offset of first pixel in word k
+    scnword_t  hiWord = 0;
+    scnword_t  loWord = 0;
+
+    if (bitIndex <= -SCN_WORD_BITS)  return 0;            // all pixels left of row
+    k = (bitIndex + SCN_WORD_BITS) / SCN_WORD_BITS - 1;   // rounded down
+    shift = bitIndex - k * SCN_WORD_BITS;
+
+    if (k >= 0 && k < wordsInRow)  hiWord = rowData[k];
+    if (shift == 0)  return hiWord;   // word-aligned
+
+    if ((k + 1) < wordsInRow)  loWord = rowData[k + 1];
+
+    return  (scnword_t) ((hiWord << shift) | (loWord >> (SCN_WORD_BITS - shift)));
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_CountRows()
+ *
+ * Function           :  Row-major buffer kernel for LCD_CountPixels().
+ *                       The pixels in the first and last column-words of each row are
+ *                       masked as by LCD_FillRows();  the bits set in each column-word
+ *                       are counted in parallel (see LCD_CountBits).
+ *
+ * Input              :  src = surface to be read
+ *                       x, y = pixel coords of upper LHS of block (within surface)
+ *                       w, h = width and height (pixels) of block, w > 0, h > 0
+ *
+ * Return             :  number of pixels set in the block
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  int  LCD_CountRows(surface_t *src, int x, int y, int w, int h)
+{
+    int     row, col;
+    int     firstCol = x / SCN_WORD_BITS;
+    int     lastCol = (x + w - 1) / SCN_WORD_BITS;
+    scnword_t  leftMask = SCN_WORD_ONES >> (x % SCN_WORD_BITS);
+    scnword_t  rightMask = SCN_WORD_ONES << (SCN_WORD_BITS - 1 - (x + w - 1) % SCN_WORD_BITS);
+    scnword_t  *pRow;
+    int     total = 0;
+
+    if (firstCol == lastCol)  leftMask &= rightMask;   // block within one column-word
+
+    for (row = y;  row < (y + h);  row++)
+    {
+        pRow = src->bits + row * src->stride;
+        total += LCD_CountBits(pRow[firstCol] & leftMask);
+        if (firstCol == lastCol)  continue;
+
+        for (col = firstCol + 1;  col < lastCol;  col++)
+        {
+            total += LCD_CountBits(pRow[col]);
+        }
+        total += LCD_CountBits(pRow[lastCol] & rightMask);
+    }
+
+    return  total;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ScrollRows()
+ *
+ * Function           :  Row-major buffer kernel for LCD_ScrollRegion().
+ *                       Rows (and column-words within a row) are processed in the order
+ *                       which reads every source word before it is overwritten.  A vertical
+ *                       move copies whole words between rows;  a horizontal move forms each
+ *                       word from two source words by a single shift-and-merge.
+ *
+ * Input              :  dst = surface to be modified
+ *                       x, y = pixel coords of upper LHS of block
+ *                       w, h = width and height of block (clipped to surface)
+ *                       dx, dy = distance to move pixels (|dx| <= w, |dy| <= h)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_ScrollRows(surface_t *dst, int x, int y, int w, int h, int dx, int dy)
+{
+    int     n, i;
+    int     row, col;               // row index, column-word index in surface
+    int     srcRow;                 // row from which pixels are moved into row
+    int     firstCol;               // first (leftmost) column-word in a row to be modified
+    int     lastCol;                // last (rightmost) column-word in a row to be modified
+    int     validLeft, validRight;  // pixels in row [validLeft, validRight) not exposed
+    int     lo, hi;                 // valid pixels, relative to MS bit of column-word
+    scnword_t  leftMask;            // pixels to be modified in first column-word
+    scnword_t  rightMask;           // pixels to be modified in last column-word
+    scnword_t  bitmask;             // pixels in column-word covered by block
+    scnword_t  validMask;           // pixels in column-word which receive moved pixels
+    scnword_t  pixelWord;
+    scnword_t  *pRow, *pSrc;
+
+    firstCol = x / SCN_WORD_BITS;
+    lastCol = (x + w - 1) / SCN_WORD_BITS;
+    leftMask = SCN_WORD_ONES >> (x % SCN_WORD_BITS);
+    rightMask = SCN_WORD_ONES << (SCN_WORD_BITS - 1 - (x + w - 1) % SCN_WORD_BITS);
+    if (firstCol == lastCol)  leftMask &= rightMask;
+
+    validLeft = (dx > 0) ? (x + dx) : x;
+    validRight = (dx < 0) ? (x + w + dx) : (x + w);
+
+    for (n = 0;  n < h;  n++)
+    {
+        row = (dy > 0) ? (y + h - 1 - n) : (y + n);   // moving down => start at bottom
+        srcRow = row - dy;
+        pRow = dst->bits + row * dst->stride;
+        pSrc = dst->bits + srcRow * dst->stride;
+
+        if (srcRow < y || srcRow >= (y + h) || validLeft >= validRight)   // exposed row
+        {
+            LCD_RasterOp(&pRow[firstCol], 0, leftMask, COPY_PIXELS);
+            for (col = firstCol + 1;  col < lastCol;  col++)  pRow[col] = 0;
+            if (lastCol != firstCol)  LCD_RasterOp(&pRow[lastCol], 0, rightMask, COPY_PIXELS);
+        }
+        else if (dx == 0)   // vertical move only -- copy row, masked at the ends
+        {
+            LCD_RasterOp(&pRow[firstCol], pSrc[firstCol] & leftMask, leftMask, COPY_PIXELS);
+            if ((lastCol - firstCol) > 1)
+                memcpy(&pRow[firstCol + 1], &pSrc[firstCol + 1],
+                       (lastCol - firstCol - 1) * sizeof(scnword_t));
+            if (lastCol != firstCol)
+                LCD_RasterOp(&pRow[lastCol], pSrc[lastCol] & rightMask, rightMask, COPY_PIXELS);
+        }
+        else  // moving right => start at RHS
+        {
+            for (i = 0;  i <= (lastCol - firstCol);  i++)
+            {
+                col = (dx > 0) ? (lastCol - i) : (firstCol + i);
+                bitmask = SCN_WORD_ONES;
+                if (col == firstCol)  bitmask = leftMask;
+                else if (col == lastCol)  bitmask = rightMask;
+
+                lo = validLeft - col * SCN_WORD_BITS;
+                hi = validRight - col * SCN_WORD_BITS;
+                validMask = SCN_WORD_ONES;
+                if (lo > 0)  validMask = (lo >= SCN_WORD_BITS) ? 0 : (validMask >> lo);
+                if (hi < SCN_WORD_BITS)  validMask &= (hi <= 0) ? 0 : ~(SCN_WORD_ONES >> hi);
+
+                pixelWord = LCD_GetSurfaceWord(pSrc, col * SCN_WORD_BITS - dx, dst->stride);
+
+                LCD_RasterOp(&pRow[col], pixelWord & validMask, bitmask, COPY_PIXELS);
+            }
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_GetImageWord()
+ *
+ * Function           :  Packs SCN_WORD_BITS / 8 bytes of an image row into a column-word,
+ *                       first (left) byte in the high-order position.  Bytes outside the
+ *                       image row (index < 0 or >= bytesInRow) are read as zero.
+ *
+ * Input              :  rowData = pointer to first byte of image row
+ *                       byteIndex = index of first byte to pack (may be negative)
+ *                       bytesInRow = number of bytes per image row
+ *
+ * Return             :  Column-word of image pixels
+ *--------------------------------------------------------------------------------------*/
+INLINE  scnword_t  LCD_GetImageWord(uint8 *rowData, int byteIndex, int bytesInRow)
+{
+    scnword_t  imageWord = 0;
+    int     i;
+
+    if (byteIndex >= 0 && (byteIndex + SCN_WORD_BITS / 8) <= bytesInRow)
+    {
+        for (i = 0;  i < SCN_WORD_BITS / 8;  i++)  // whole word within row
+        {
+            imageWord = (imageWord << 8) | rowData[byteIndex + i];
+        }
+    }
+    else  // word overlaps start or end of row
+    {
+        for (i = 0;  i < SCN_WORD_BITS / 8;  i++, byteIndex++)
+        {
+            imageWord <<= 8;
+            if (byteIndex >= 0 && byteIndex < bytesInRow)  imageWord |= rowData[byteIndex];
+        }
+    }
+
+    return  imageWord;
+}
+#endif  // !LCD_BUFFER_PAGE_MAJOR
+
+
+#ifdef LCD_BUFFER_PAGE_MAJOR
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FillPages()
+ *
+ * Function           :  Page-major buffer kernel for LCD_BlockFill().
+ *                       Fills a block of w x h pixels at (x, y) using the global
+ *                       writing mode.  Each buffer byte covered by the block is modified
+ *                       once, using a mask of the rows within its page.
+ *
+ * Input              :  dst = surface to be modified
+ *                       x, y = pixel coords of upper LHS of block (x + w <= dst width)
+ *                       w, h = width and height (pixels) of block
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_FillPages(surface_t *dst, int x, int y, int w, int h)
+{
+    int     page, lastPage, i;
+    uint8   rowMask;                // rows in page to be modified, bit 0 = top row
+    uint8   *pBuf;
+
+    if (y >= dst->height || w <= 0 || h <= 0)  return;
+    if ((y + h) > dst->height)  h = dst->height - y;
+
+    lastPage = (y + h - 1) / 8;
+
+    for (page = y / 8;  page <= lastPage;  page++)
+    {
+        rowMask = 0xFF;
+        if (y > page * 8)  rowMask &= 0xFF << (y - page * 8);
+        if ((y + h) < (page * 8 + 8))  rowMask &= 0xFF >> (page * 8 + 8 - (y + h));
+
+        pBuf = dst->bits + page * dst->stride + x;
+
+        if (Ctx->pixelMode == SET_PIXELS || Ctx->pixelMode == COPY_PIXELS)
+            for (i = 0;  i < w;  i++)  *pBuf++ |= rowMask;
+        else if (Ctx->pixelMode == CLEAR_PIXELS)
+            for (i = 0;  i < w;  i++)  *pBuf++ &= ~rowMask;
+        else if (Ctx->pixelMode == FLIP_PIXELS)
+            for (i = 0;  i < w;  i++)  *pBuf++ ^= rowMask;
+        // else AND_PIXELS -- AND with a solid block has no effect
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutImagePages()
+ *
+ * Function           :  Page-major buffer kernel for LCD_PutImage().
+ *                       For each page covered by the image, 8 image rows (aligned to the
+ *                       page) are gathered 8 pixels at a time and transposed into 8
+ *                       vertical bytes, which are written to the buffer using the global
+ *                       writing mode.  If a mask is given, it is transposed likewise and
+ *                       the image is copied to the buffer where the mask pixels are set.
+ *
+ * Input              :  dst = surface to be modified
+ *                       imageData = pointer to bit-map image data (see LCD_PutImage)
+ *                       maskData = pointer to mask bit-map, same format, or NULL
+ *                       x, y = pixel coords of upper LHS of image (x + w <= dst width)
+ *                       w, h = image width (clipped) and height, pixels
+ *                       bytesInRow = number of bytes per image row in imageData
+ *                       sx = image column drawn at x (> 0 if clipped on the left)
+ *                       info = collision report to be added to (see LCD_GetCollision),
+ *                              or NULL if image pixels are not tested against buffer
+ *
+ * Return             :  TRUE (1) if any image pixel collides with a pixel already set
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  uint8  LCD_PutImagePages(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                  int x, int y, int w, int h, int bytesInRow, int sx,
+                                  collision_t *info)
+{
+    uint8   mode = Ctx->pixelMode;
+
+    if (y >= dst->height || w <= 0 || h <= 0)  return 0;
+    if ((y + h) > dst->height)  h = dst->height - y;
+
+    if (maskData != NULL)
+    {
+        if (info != NULL)
+            return LCD_PutImagePagesOp(dst, imageData, maskData, x, y, w, h,
+                                       bytesInRow, sx, COPY_PIXELS, TRUE, info);
+        return LCD_PutImagePagesOp(dst, imageData, maskData, x, y, w, h,
+                                   bytesInRow, sx, COPY_PIXELS, FALSE, NULL);
+    }
+
+    if (info != NULL)
+    {
+        switch (mode)
+        {
+        case SET_PIXELS:    return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                       bytesInRow, sx, SET_PIXELS, TRUE, info);
+        case CLEAR_PIXELS:  return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                       bytesInRow, sx, CLEAR_PIXELS, TRUE, info);
+        case FLIP_PIXELS:   return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                       bytesInRow, sx, FLIP_PIXELS, TRUE, info);
+        case COPY_PIXELS:   return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                       bytesInRow, sx, COPY_PIXELS, TRUE, info);
+        default:            return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                       bytesInRow, sx, AND_PIXELS, TRUE, info);
+        }
+    }
+
+    switch (mode)
+    {
+    case SET_PIXELS:    return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                   bytesInRow, sx, SET_PIXELS, FALSE, NULL);
+    case CLEAR_PIXELS:  return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                   bytesInRow, sx, CLEAR_PIXELS, FALSE, NULL);
+    case FLIP_PIXELS:   return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                   bytesInRow, sx, FLIP_PIXELS, FALSE, NULL);
+    case COPY_PIXELS:   return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                   bytesInRow, sx, COPY_PIXELS, FALSE, NULL);
+    default:            return LCD_PutImagePagesOp(dst, imageData, NULL, x, y, w, h,
+                                                   bytesInRow, sx, AND_PIXELS, FALSE, NULL);
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutImagePagesOp()
+ *
+ * Function           :  Worker for LCD_PutImagePages(), expanded in line for each
+ *                       writing mode, with and without the collision test.
+ *
+ * Input              :  dst, imageData, maskData, x, y, w, h, bytesInRow, sx =
+ *                       see LCD_PutImagePages()  (image clipped to surface, w > 0, h > 0)
+ *                       mode = pixel writing mode (constant);  TEST_PIXELS to return
+ *                              on the first collision, without modifying the buffer
+ *                       checkCollision = TRUE to test for collision (constant)
+ *                       info = collision report (if checkCollision, and not TEST_PIXELS)
+ *
+ * Return             :  TRUE (1) if any image pixel collides with a pixel already set
+ *--------------------------------------------------------------------------------------*/
+INLINE  uint8  LCD_PutImagePagesOp(surface_t *dst, uint8 *imageData, uint8 *maskData,
+                                   int x, int y, int w, int h, int bytesInRow, int sx,
+                                   uint8 mode, bool checkCollision, collision_t *info)
+{
+    int     page, lastPage;
+    int     row, i, k, c;           // image row, row in page, byte column, pixel column
+    uint8   rowBytes[8];            // 8 image rows x 8 pixels, aligned to page
+    uint8   colBytes[8];            // the same pixels, transposed (8 vertical bytes)
+    uint8   maskBytes[8];           // mask bit-map, rows then transposed to columns
+    uint8   pageMask;               // rows in page covered by image, bit 0 = top row
+    uint8   bitmask;                // pixels in buffer byte covered by image
+    uint8   anyPixels;
+    uint32  overlap;                // image pixels which fall on pixels already set
+    int     col;                    // buffer x-coord of overlap
+    uint8   *pBuf;
+    uint8   collision = 0;
+
+    lastPage = (y + h - 1) / 8;
+
+    for (page = y / 8;  page <= lastPage;  page++)
+    {
+        pageMask = 0xFF;
+        if (y > page * 8)  pageMask &= 0xFF << (y - page * 8);
+        if ((y + h) < (page * 8 + 8))  pageMask &= 0xFF >> (page * 8 + 8 - (y + h));
+
+        for (k = sx / 8;  k <= (sx + w - 1) / 8;  k++)
+        {
+            anyPixels = 0;
+            for (i = 0;  i < 8;  i++)  // gather 8 rows of image byte column k
+            {
+                row = page * 8 + i - y;
+                if (row >= 0 && row < h)  rowBytes[i] = imageData[row * bytesInRow + k];
+                else  rowBytes[i] = 0;
+
+                if (maskData != NULL)
+                {
+                    if (row >= 0 && row < h)  maskBytes[i] = maskData[row * bytesInRow + k];
+                    else  maskBytes[i] = 0;
+                    anyPixels |= maskBytes[i];
+                }
+                else  anyPixels |= rowBytes[i];
+            }
+            // Blank image (or mask) pixels have no effect, except in COPY and AND modes
+            if (anyPixels == 0 && (maskData != NULL || mode <= FLIP_PIXELS
+                                   || mode == TEST_PIXELS))  continue;
+
+            LCD_Transpose8x8(rowBytes, colBytes);
+            if (maskData != NULL)  LCD_Transpose8x8(maskBytes, maskBytes);
+            c = (k * 8 < sx) ? (sx - k * 8) : 0;   // skip columns clipped on the left
+            pBuf = dst->bits + page * dst->stride + x + (k * 8 + c - sx);
+
+            for ( ;  c < 8 && (k * 8 + c) < (sx + w);  c++, pBuf++)
+            {
+                bitmask = pageMask;
+                if (maskData != NULL)  bitmask &= maskBytes[c];
+                colBytes[c] &= bitmask;
+
+                if (checkCollision && (*pBuf & colBytes[c]))
+                {
+                    if (mode == TEST_PIXELS)  return 1;   // nothing to draw -- done
+                    collision = 1;
+                    overlap = *pBuf & colBytes[c];
+                    col = pBuf - (dst->bits + page * dst->stride);
+                    LCD_AddCollision(info, col, page * 8 + __builtin_ctz(overlap), col + 1,
+                                     page * 8 + 32 - __builtin_clz(overlap),
+                                     LCD_CountBits(overlap));
+                }
+
+                LCD_RasterOp(pBuf, colBytes[c], bitmask, mode);
+            }
+        }
+    }
+
+    return  collision;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_BlitSurfacePages()
+ *
+ * Function           :  Page-major buffer kernel for LCD_PutSurface().
+ *                       Each target byte is formed from two vertically adjacent source
+ *                       bytes by a single shift-and-merge, then written using the global
+ *                       writing mode.
+ *
+ * Input              :  dst = surface to be modified
+ *                       src = source surface
+ *                       sx, sy = pixel coords of upper LHS of block in source
+ *                       x, y = pixel coords of upper LHS of block in target
+ *                       w, h = width and height of block (clipped to both surfaces)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_BlitSurfacePages(surface_t *dst, surface_t *src, int sx, int sy,
+                                    int x, int y, int w, int h)
+{
+    if (w <= 0 || h <= 0)  return;
+
+    switch (Ctx->pixelMode)
+    {
+    case SET_PIXELS:    LCD_BlitSurfacePagesOp(dst, src, sx, sy, x, y, w, h, SET_PIXELS);  break;
+    case CLEAR_PIXELS:  LCD_BlitSurfacePagesOp(dst, src, sx, sy, x, y, w, h, CLEAR_PIXELS);  break;
+    case FLIP_PIXELS:   LCD_BlitSurfacePagesOp(dst, src, sx, sy, x, y, w, h, FLIP_PIXELS);  break;
+    case COPY_PIXELS:   LCD_BlitSurfacePagesOp(dst, src, sx, sy, x, y, w, h, COPY_PIXELS);  break;
+    default:            LCD_BlitSurfacePagesOp(dst, src, sx, sy, x, y, w, h, AND_PIXELS);  break;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_BlitSurfacePagesOp()
+ *
+ * Function           :  Worker for LCD_BlitSurfacePages(), expanded in line for each
+ *                       writing mode.
+ *
+ * Input              :  dst, src, sx, sy, x, y, w, h = see LCD_BlitSurfacePages()
+ *                       mode = pixel writing mode (constant)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_BlitSurfacePagesOp(surface_t *dst, surface_t *src, int sx, int sy,
+                                     int x, int y, int w, int h, uint8 mode)
+{
+    int     page, lastPage, c;
+    int     srcRow;                 // source row aligned with top row of target page
+    int     k;                      // source page holding srcRow
+    int     shift;                  // bit offset of srcRow in source page k
+    int     srcPages;               // number of pages in source surface
+    uint8   pageMask;               // rows in page covered by block, bit 0 = top row
+    uint8   pixels;
+    uint8   *pBuf;
+    uint8   *pUpper, *pLower;       // source bytes in pages k and k+1 (NULL if none)
+
+    lastPage = (y + h - 1) / 8;
+    srcPages = (src->height + 7) / 8;
+
+    for (page = y / 8;  page <= lastPage;  page++)
+    {
+        pageMask = 0xFF;
+        if (y > page * 8)  pageMask &= 0xFF << (y - page * 8);
+        if ((y + h) < (page * 8 + 8))  pageMask &= 0xFF >> (page * 8 + 8 - (y + h));
+
+        srcRow = sy + page * 8 - y;
+        k = (srcRow + 8) / 8 - 1;   // rounded down
+        shift = srcRow - k * 8;
+
+        pUpper = (k >= 0 && k < srcPages) ? src->bits + k * src->stride + sx : NULL;
+        pLower = ((k + 1) < srcPages) ? src->bits + (k + 1) * src->stride + sx : NULL;
+        pBuf = dst->bits + page * dst->stride + x;
+
+        for (c = 0;  c < w;  c++, pBuf++)
+        {
+            pixels = 0;
+            if (pUpper != NULL)  pixels = pUpper[c] >> shift;
+            if (pLower != NULL && shift != 0)  pixels |= pLower[c] << (8 - shift);
+            pixels &= pageMask;
+
+            LCD_RasterOp(pBuf, pixels, pageMask, mode);
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ScrollPages()
+ *
+ * Function           :  Page-major buffer kernel for LCD_ScrollRegion().
+ *                       Pages (and columns within a page) are processed in the order
+ *                       which reads every source byte before it is overwritten.  A vertical
+ *                       move forms each byte from two source bytes by a shift-and-merge;
+ *                       a horizontal move of whole pages is a byte copy within the page.
+ *
+ * Input              :  dst = surface to be modified
+ *                       x, y = pixel coords of upper LHS of block
+ *                       w, h = width and height of block (clipped to surface)
+ *                       dx, dy = distance to move pixels (|dx| <= w, |dy| <= h)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_ScrollPages(surface_t *dst, int x, int y, int w, int h, int dx, int dy)
+{
+    int     n, i, c;
+    int     page, firstPage, lastPage;
+    int     pages;                  // number of pages in surface
+    int     srcRow;                 // row from which pixels are moved into top row of page
+    int     k;                      // page holding srcRow
+    int     shift;                  // bit offset of srcRow in page k
+    int     validTop, validBottom;  // rows [validTop, validBottom) not exposed
+    uint8   pageMask;               // rows in page covered by block, bit 0 = top row
+    uint8   validMask;              // rows in page which receive moved pixels
+    uint8   pixels;
+    uint8   *pBuf;
+    uint8   *pUpper, *pLower;       // source bytes in pages k and k+1 (NULL if none)
+
+    firstPage = y / 8;
+    lastPage = (y + h - 1) / 8;
+    pages = (dst->height + 7) / 8;
+    validTop = (dy > 0) ? (y + dy) : y;
+    validBottom = (dy < 0) ? (y + h + dy) : (y + h);
+
+    for (n = 0;  n <= (lastPage - firstPage);  n++)
+    {
+        page = (dy > 0) ? (lastPage - n) : (firstPage + n);   // moving down => start at bottom
+        pBuf = dst->bits + page * dst->stride;
+
+        pageMask = 0xFF;
+        if (y > page * 8)  pageMask &= 0xFF << (y - page * 8);
+        if ((y + h) < (page * 8 + 8))  pageMask &= 0xFF >> (page * 8 + 8 - (y + h));
+
+        if (dy == 0 && pageMask == 0xFF)   // horizontal move of whole page -- byte copy
+        {
+            if (dx > 0)
+            {
+                memmove(&pBuf[x + dx], &pBuf[x], w - dx);
+                memset(&pBuf[x], 0, dx);
+            }
+            else
+            {
+                memmove(&pBuf[x], &pBuf[x - dx], w + dx);
+                memset(&pBuf[x + w + dx], 0, -dx);
+            }
+            continue;
+        }
+
+        validMask = pageMask;
+        if (validTop > page * 8)
+            validMask &= (validTop >= page * 8 + 8) ? 0 : (0xFF << (validTop - page * 8));
+        if (validBottom < (page * 8 + 8))
+            validMask &= (validBottom <= page * 8) ? 0 : (0xFF >> (page * 8 + 8 - validBottom));
+
+        srcRow = page * 8 - dy;
+        k = (srcRow + 8) / 8 - 1;   // rounded down
+        shift = srcRow - k * 8;
+
+        pUpper = (k >= 0 && k < pages) ? dst->bits + k * dst->stride : NULL;
+        pLower = ((k + 1) >= 0 && (k + 1) < pages) ? dst->bits + (k + 1) * dst->stride : NULL;
+
+        for (i = 0;  i < w;  i++)
+        {
+            c = (dx > 0) ? (x + w - 1 - i) : (x + i);   // moving right => start at RHS
+            pixels = 0;
+            if (validMask != 0 && (c - dx) >= x && (c - dx) < (x + w))
+            {
+                if (pUpper != NULL)  pixels = pUpper[c - dx] >> shift;
+                if (pLower != NULL && shift != 0)  pixels |= pLower[c - dx] << (8 - shift);
+                pixels &= validMask;
+            }
+
+            LCD_RasterOp(&pBuf[c], pixels, pageMask, COPY_PIXELS);
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_CountPages()
+ *
+ * Function           :  Page-major buffer kernel for LCD_CountPixels().
+ *                       Pages wholly within the block are counted a machine word at a
+ *                       time (see LCD_CountBytes);  in the top and bottom pages, each
+ *                       byte is masked to the rows within the block.
+ *
+ * Input              :  src = surface to be read
+ *                       x, y = pixel coords of upper LHS of block (within surface)
+ *                       w, h = width and height (pixels) of block, w > 0, h > 0
+ *
+ * Return             :  number of pixels set in the block
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  int  LCD_CountPages(surface_t *src, int x, int y, int w, int h)
+{
+    int     page, lastPage, c;
+    uint8   pageMask;               // rows in page within block, bit 0 = top row
+    uint8   *pBuf;
+    int     total = 0;
+
+    lastPage = (y + h - 1) / 8;
+
+    for (page = y / 8;  page <= lastPage;  page++)
+    {
+        pageMask = 0xFF;
+        if (y > page * 8)  pageMask &= 0xFF << (y - page * 8);
+        if ((y + h) < (page * 8 + 8))  pageMask &= 0xFF >> (page * 8 + 8 - (y + h));
+        pBuf = src->bits + page * src->stride + x;
+
+        if (pageMask == 0xFF)  total += LCD_CountBytes(pBuf, w);
+        else
+        {
+            for (c = 0;  c < w;  c++)  total += LCD_CountBits(pBuf[c] & pageMask);
+        }
+    }
+
+    return  total;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_Transpose8x8()
+ *
+ * Function           :  Transpose a block of 8 x 8 pixels from horizontal bytes (image rows,
+ *                       bit 7 at LHS) to vertical bytes (buffer columns, bit 0 at top),
+ *                       using 3 stages of masked bit swaps on two 32-bit words.
+ *
+ * Input              :  rowBytes = 8 rows of 8 pixels, top row first
+ * Output             :  colBytes = 8 columns of 8 pixels, LHS column first
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_Transpose8x8(uint8 *rowBytes, uint8 *colBytes)
+{
+    uint32  hi, lo, t;
+
+    // Pack rows in reverse order, so that the top row ends up in bit 0 of each column
+    hi = ((uint32) rowBytes[7] << 24) | ((uint32) rowBytes[6] << 16)
+       | ((uint32) rowBytes[5] << 8) | rowBytes[4];
+    lo = ((uint32) rowBytes[3] << 24) | ((uint32) rowBytes[2] << 16)
+       | ((uint32) rowBytes[1] << 8) | rowBytes[0];
+
+    t = (hi ^ (hi >> 7)) & 0x00AA00AA;  hi = hi ^ t ^ (t << 7);   // swap 1 x 1 bits
+    t = (lo ^ (lo >> 7)) & 0x00AA00AA;  lo = lo ^ t ^ (t << 7);
+    t = (hi ^ (hi >> 14)) & 0x0000CCCC;  hi = hi ^ t ^ (t << 14);  // swap 2 x 2 bits
+    t = (lo ^ (lo >> 14)) & 0x0000CCCC;  lo = lo ^ t ^ (t << 14);
+
+    t = (hi & 0xF0F0F0F0) | ((lo >> 4) & 0x0F0F0F0F);            // swap 4 x 4 bits
+    lo = ((hi << 4) & 0xF0F0F0F0) | (lo & 0x0F0F0F0F);
+    hi = t;
+
+    colBytes[0] = (uint8) (hi >> 24);
+    colBytes[1] = (uint8) (hi >> 16);
+    colBytes[2] = (uint8) (hi >> 8);
+    colBytes[3] = (uint8) hi;
+    colBytes[4] = (uint8) (lo >> 24);
+    colBytes[5] = (uint8) (lo >> 16);
+    colBytes[6] = (uint8) (lo >> 8);
+    colBytes[7] = (uint8) lo;
+}
+#endif  // LCD_BUFFER_PAGE_MAJOR
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_DrawLineRuns()
+ *
+ * Function           :  Line kernel for LCD_DrawLine().  Steps along the major axis (the
+ *                       longer one) of the line;  the minor axis offset at step i is
+ *                       i * minor / major, rounded, which Bresenham's algorithm tracks
+ *                       by an error term, without division.  The steps outside the
+ *                       visible block are skipped by computing the offset and error at
+ *                       the first visible step.  Pixels with the same minor offset form
+ *                       a run (horizontal if the line is mostly horizontal, else
+ *                       vertical), which is filled by the block fill kernel in one call.
+ *
+ * Input              :  dst = surface to be modified
+ *                       x0, y0 = start point;  x1, y1 = end point (not in line with x0
+ *                                or y0 -- horizontal and vertical lines are one run)
+ *                       left, top, w, h = visible block enclosing the line (clipped)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_DrawLineRuns(surface_t *dst, int x0, int y0, int x1, int y1,
+                                int left, int top, int w, int h)
+{
+    int     stepX = (x1 > x0) ? 1 : -1;
+    int     stepY = (y1 > y0) ? 1 : -1;
+    int     dx = (x1 - x0) * stepX;
+    int     dy = (y1 - y0) * stepY;
+    bool    xMajor = (dx >= dy);    // TRUE => runs are horizontal
+    int     major = xMajor ? dx : dy;
+    int     minor = xMajor ? dy : dx;
+    int     first, last;            // visible steps along the major axis
+    int     i, runStart;            // step;  first step of current run
+    int     offset;                 // minor axis offset of current run
+    int     error;                  // 2 * (i * minor) + major, modulo 2 * major
+    int     a, b, c;                // run from a to b (major axis) at c (minor axis)
+    int64   sum;
+
+    if (xMajor)  first = (stepX > 0) ? (left - x0) : (x0 - (left + w - 1));
+    else  first = (stepY > 0) ? (top - y0) : (y0 - (top + h - 1));
+    last = first + (xMajor ? w : h) - 1;
+
+    sum = (int64) 2 * first * minor + major;
+    offset = (int) (sum / (2 * major));
+    error = (int) (sum % (2 * major));
+
+    for (runStart = i = first;  i <= last;  i++)
+    {
+        error += 2 * minor;         // error at step i + 1
+        if (error < 2 * major && i < last)  continue;   // same run
+
+        if (xMajor)
+        {
+            a = x0 + runStart * stepX;
+            b = x0 + i * stepX;
+            c = y0 + offset * stepY;
+            if (c >= top && c < top + h)  LCD_FillRun(dst, MIN(a, b), c, i - runStart + 1, 1);
+        }
+        else
+        {
+            a = y0 + runStart * stepY;
+            b = y0 + i * stepY;
+            c = x0 + offset * stepX;
+            if (c >= left && c < left + w)  LCD_FillRun(dst, c, MIN(a, b), 1, i - runStart + 1);
+        }
+
+        if (error >= 2 * major)  { error -= 2 * major;  offset++; }
+        runStart = i + 1;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FillRun()
+ * Function           :  Fill a run of pixels (w x 1 or 1 x h) for LCD_DrawLine(), using
+ *                       the block fill kernel for the buffer format.
+ * Input              :  dst, x, y, w, h = block (within surface and clip rectangle)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_FillRun(surface_t *dst, int x, int y, int w, int h)
+{
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    LCD_FillPages(dst, x, y, w, h);
+#else
+    LCD_FillRows(dst, x, y, w, h);
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FillTarget()
+ *
+ * Function           :  Fill the whole target within the clip rectangle in a given mode,
+ *                       for LCD_FillScreen() and LCD_InvertScreen().  If the clip is the
+ *                       whole target and the call is drawn (not recorded), the buffer is
+ *                       filled by the whole-buffer kernel, otherwise by LCD_BlockFill().
+ *
+ * Input              :  mode = pixel writing mode (CLEAR, SET or FLIP)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_FillTarget(uint8 mode)
+{
+    surface_t  *dst = Ctx->target;
+    uint8   savedMode = Ctx->pixelMode;
+    int16   posX = Ctx->cursorPosX;
+    int16   posY = Ctx->cursorPosY;
+
+    if (dst->bits != NULL && LCD_GetRecorder(FALSE) == NULL
+        && Ctx->clipLeft == 0 && Ctx->clipTop == 0
+        && Ctx->clipRight == dst->width && Ctx->clipBottom == dst->height)
+    {
+        LCD_FillBytes((uint8 *) dst->bits,
+                      SURFACE_WORDS(dst->width, dst->height) * sizeof(scnword_t), mode);
+        if (mode != CLEAR_PIXELS)  LCD_ClearPadding(dst);
+        LCD_UpdateBlock(0, 0, dst->width, dst->height);
+        return;
+    }
+
+    if (mode != savedMode)  LCD_Mode(mode);
+    Ctx->cursorPosX = Ctx->clipLeft;
+    Ctx->cursorPosY = Ctx->clipTop;
+    LCD_BlockFill(Ctx->clipRight - Ctx->clipLeft, Ctx->clipBottom - Ctx->clipTop);
+    Ctx->cursorPosX = posX;
+    Ctx->cursorPosY = posY;
+    if (mode != savedMode)  LCD_Mode(savedMode);
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FillBytes()
+ *
+ * Function           :  Whole-buffer kernel -- clear, set or flip every bit in a buffer,
+ *                       a machine word (lcdword_t) at a time, with single bytes before the
+ *                       first word boundary and after the last.  The pixel format does
+ *                       not matter, as every bit is treated alike.
+ *
+ * Input              :  pData = address of buffer;  count = buffer size, bytes
+ *                       mode = CLEAR_PIXELS, SET_PIXELS (or COPY) or FLIP_PIXELS;
+ *                              AND_PIXELS leaves the buffer unchanged (as block fill)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_FillBytes(uint8 *pData, int count, uint8 mode)
+{
+    lcdword_t  *pWord;
+    lcdword_t  fill = (mode == CLEAR_PIXELS) ? 0 : ~(lcdword_t) 0;
+
+    if (mode == AND_PIXELS)  return;
+
+    for ( ;  count > 0 && ((size_t) pData % sizeof(lcdword_t)) != 0;  count--, pData++)
+    {
+        *pData = (mode == FLIP_PIXELS) ? (uint8) ~*pData : (uint8) fill;
+    }
+
+    pWord = (lcdword_t *) pData;
+    if (mode == FLIP_PIXELS)
+    {
+        for ( ;  count >= (int) sizeof(lcdword_t);  count -= sizeof(lcdword_t), pWord++)
+            *pWord = ~*pWord;
+    }
+    else
+    {
+        for ( ;  count >= (int) sizeof(lcdword_t);  count -= sizeof(lcdword_t), pWord++)
+            *pWord = fill;
+    }
+
+    for (pData = (uint8 *) pWord;  count > 0;  count--, pData++)
+    {
+        *pData = (mode == FLIP_PIXELS) ? (uint8) ~*pData : (uint8) fill;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_CountBytes()
+ *
+ * Function           :  Whole-buffer kernel -- count the bits set in a buffer, a machine
+ *                       word at a time (see LCD_CountBits).
+ *
+ * Input              :  pData = address of buffer;  count = buffer size, bytes
+ * Return             :  number of bits set
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  int  LCD_CountBytes(uint8 *pData, int count)
+{
+    lcdword_t  *pWord;
+    int     total = 0;
+
+    for ( ;  count > 0 && ((size_t) pData % sizeof(lcdword_t)) != 0;  count--, pData++)
+    {
+        total += LCD_CountBits(*pData);
+    }
+
+    pWord = (lcdword_t *) pData;
+    for ( ;  count >= (int) sizeof(lcdword_t);  count -= sizeof(lcdword_t), pWord++)
+    {
+        total += LCD_CountBits(*pWord);
+    }
+
+    for (pData = (uint8 *) pWord;  count > 0;  count--, pData++)
+    {
+        total += LCD_CountBits(*pData);
+    }
+
+    return  total;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_CountBits()
+ *
+ * Function           :  Count the bits set in a machine word, by adding bit counts in
+ *                       parallel within the word (2-bit, 4-bit, then 8-bit fields), then
+ *                       summing the byte counts with a single multiply.
+ *
+ * Input              :  bits = word (or smaller buffer word, zero-extended)
+ * Return             :  number of bits set
+ *--------------------------------------------------------------------------------------*/
+INLINE  int  LCD_CountBits(lcdword_t bits)
+{
+    bits = bits - ((bits >> 1) & (lcdword_t) 0x5555555555555555ULL);
+    bits = (bits & (lcdword_t) 0x3333333333333333ULL)
+           + ((bits >> 2) & (lcdword_t) 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & (lcdword_t) 0x0F0F0F0F0F0F0F0FULL;
+
+    return  (int) ((bits * (lcdword_t) 0x0101010101010101ULL) >> (sizeof(lcdword_t) * 8 - 8));
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_CompareBytes()
+ *
+ * Function           :  Whole-buffer kernel -- compare two buffers, a machine word at a
+ *                       time if they are equally aligned (otherwise byte by byte).
+ *
+ * Input              :  pData1, pData2 = addresses of buffers;  count = size, bytes
+ * Return             :  TRUE if the buffers are the same
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  bool  LCD_CompareBytes(uint8 *pData1, uint8 *pData2, int count)
+{
+    lcdword_t  *pWord1, *pWord2;
+
+    if (((size_t) pData1 - (size_t) pData2) % sizeof(lcdword_t) == 0)
+    {
+        for ( ;  count > 0 && ((size_t) pData1 % sizeof(lcdword_t)) != 0;  count--)
+        {
+            if (*pData1++ != *pData2++)  return FALSE;
+        }
+
+        pWord1 = (lcdword_t *) pData1;
+        pWord2 = (lcdword_t *) pData2;
+        for ( ;  count >= (int) sizeof(lcdword_t);  count -= sizeof(lcdword_t))
+        {
+            if (*pWord1++ != *pWord2++)  return FALSE;
+        }
+        pData1 = (uint8 *) pWord1;
+        pData2 = (uint8 *) pWord2;
+    }
+
+    for ( ;  count > 0;  count--)
+    {
+        if (*pData1++ != *pData2++)  return FALSE;
+    }
+
+    return  TRUE;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ClearPadding()
+ *
+ * Function           :  Clear the bits of a surface buffer which hold no pixels, i.e.
+ *                       right of the last column in each row (row-major), or below the
+ *                       last row in the last page (page-major), after a whole-buffer
+ *                       fill.  Drawing functions never set these bits, so the whole-
+ *                       buffer count and compare kernels need not mask them.
+ *
+ * Input              :  surface = pointer to surface
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_ClearPadding(surface_t *surface)
+{
+    int     i;
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    uint8   *pLast;
+    uint8   mask;
+
+    if ((surface->height % 8) == 0)  return;
+    mask = 0xFF >> (8 - surface->height % 8);
+    pLast = surface->bits + (surface->height / 8) * surface->stride;
+    for (i = 0;  i < surface->width;  i++)  pLast[i] &= mask;
+#else
+    scnword_t  *pLast;
+    scnword_t  mask;
+
+    if ((surface->width % SCN_WORD_BITS) == 0)  return;
+    mask = SCN_WORD_ONES << (SCN_WORD_BITS - surface->width % SCN_WORD_BITS);
+    pLast = surface->bits + surface->stride - 1;
+    for (i = 0;  i < surface->height;  i++, pLast += surface->stride)  *pLast &= mask;
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_AddCollision()
+ *
+ * Function           :  Add colliding pixels found by an image kernel in one buffer word
+ *                       (or page byte) to a collision report:  add to the pixel count and
+ *                       extend the bounding box to enclose the pixels.
+ *
+ * Input              :  info = collision report
+ *                       left, top, right, bottom = bounds of the colliding pixels
+ *                       count = number of colliding pixels
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_AddCollision(collision_t *info, int left, int top, int right, int bottom,
+                               int count)
+{
+    if (info->count == 0)
+    {
+        info->left = left;
+        info->top = top;
+        info->right = right;
+        info->bottom = bottom;
+    }
+    else
+    {
+        if (left < info->left)  info->left = left;
+        if (top < info->top)  info->top = top;
+        if (right > info->right)  info->right = right;
+        if (bottom > info->bottom)  info->bottom = bottom;
+    }
+    info->count += count;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_GetRecorder()
+ *
+ * Function           :  Return the display list in which a call is to be recorded, if
+ *                       any:  the list being recorded by LCD_BeginRecord(), else in page
+ *                       mode, the screen list (if drawing on the screen, or if the call
+ *                       changes a setting which applies to later calls on the screen).
+ *
+ * Input              :  anyTarget = TRUE if the call changes a setting (mode, font, clip)
+ * Return             :  pointer to display list;  NULL if the call is not recorded
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  displist_t  *LCD_GetRecorder(bool anyTarget)
+{
+#ifdef LCD_PAGE_MODE
+    if (Ctx->renderingPage)  return NULL;      // replaying the screen list
+#endif
+    if (Ctx->recording != NULL)  return Ctx->recording;
+#ifdef LCD_PAGE_MODE
+    if (anyTarget || Ctx->target == &Ctx->screen)  return &Ctx->screenList;
+#else
+    (void) anyTarget;   // no screen list
+#endif
+    return NULL;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListBegin()
+ *
+ * Function           :  Start a record in a display list, if there is room for it.
+ *                       If the screen list is full, it is compacted first (see
+ *                       LCD_CompactList).  Once a record does not fit, no more calls are
+ *                       recorded in the list until it is cleared, so that the list is
+ *                       never missing a mode or font change needed by a later call.
+ *
+ * Input              :  list = pointer to display list
+ *                       opcode = record type (DL_xxx)
+ *                       size = record size, bytes, including the op-code
+ * Return             :  TRUE if the op-code was stored;  FALSE if the list is full
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  bool  LCD_ListBegin(displist_t *list, uint8 opcode, int size)
+{
+#ifdef LCD_PAGE_MODE
+    // Make room in the screen list by removing calls which are drawn over later
+    if (list == &Ctx->screenList && !list->full && (list->length + size) > list->size)
+        LCD_CompactList(list);
+#endif
+    if (list->full || (list->length + size) > list->size)
+    {
+        list->full = TRUE;
+        return FALSE;
+    }
+
+    list->data[list->length++] = opcode;
+    return TRUE;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListPut16(), LCD_ListPutPtr()
+ * Function           :  Append a 16-bit value (LS byte first) or a pointer to the record
+ *                       started by LCD_ListBegin().
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_ListPut16(displist_t *list, int value)
+{
+    list->data[list->length++] = LO_BYTE(value);
+    list->data[list->length++] = HI_BYTE(value);
+}
+
+PRIVATE  void  LCD_ListPutPtr(displist_t *list, const void *ptr)
+{
+    memcpy(&list->data[list->length], &ptr, sizeof(void *));
+    list->length += sizeof(void *);
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListGet16(), LCD_ListGetPtr()
+ * Function           :  Fetch a signed 16-bit value or a pointer from a display list
+ *                       record, and advance the data pointer past it.
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  int  LCD_ListGet16(uint8 **ppData)
+{
+    uint8  *pData = *ppData;
+
+    *ppData += 2;
+    return  (int16) (pData[0] | (pData[1] << 8));
+}
+
+PRIVATE  void  *LCD_ListGetPtr(uint8 **ppData)
+{
+    void   *ptr;
+
+    memcpy(&ptr, *ppData, sizeof(void *));
+    *ppData += sizeof(void *);
+    return  ptr;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RecordSetting()
+ * Function           :  Record a change of pixel mode or font, or removal of the clip
+ *                       rectangle.
+ * Input              :  opcode = DL_MODE, DL_FONT or DL_RESETCLIP
+ *                       value = new mode or font ID;  -1 if none (DL_RESETCLIP)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RecordSetting(uint8 opcode, int value)
+{
+    displist_t  *list = LCD_GetRecorder(TRUE);
+
+    if (list == NULL || !LCD_ListBegin(list, opcode, (value >= 0) ? 2 : 1))  return;
+
+    if (value >= 0)  list->data[list->length++] = (uint8) value;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RecordBlock()
+ *
+ * Function           :  Record a block fill, image or line drawn at the current cursor
+ *                       position.  Images are recorded by reference, so must not change
+ *                       while the list is in use.
+ *
+ * Input              :  opcode = DL_FILL, DL_IMAGE, DL_IMAGE_MASKED or DL_LINE
+ *                       w, h = width and height of block, pixels (DL_LINE: end point)
+ *                       data1, data2 = image and mask (if any) addresses
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RecordBlock(uint8 opcode, int w, int h, const void *data1, const void *data2)
+{
+    displist_t  *list = LCD_GetRecorder(FALSE);
+    int     size = 9;               // op-code, x, y, w, h
+
+    if (list == NULL)  return;
+#ifdef LCD_PAGE_MODE
+    // An opaque fill of the whole screen starts the screen list afresh (even if full)
+    if (list == &Ctx->screenList && opcode == DL_FILL && Ctx->pixelMode != FLIP_PIXELS
+        && Ctx->pixelMode != AND_PIXELS && Ctx->clipLeft == 0 && Ctx->clipTop == 0
+        && Ctx->clipRight == LCD_WIDTH && Ctx->clipBottom == LCD_HEIGHT
+        && Ctx->cursorPosX <= 0 && Ctx->cursorPosY <= 0
+        && (Ctx->cursorPosX + w) >= LCD_WIDTH && (Ctx->cursorPosY + h) >= LCD_HEIGHT)
+    {
+        list->length = 0;
+        list->full = FALSE;
+        LCD_RecordState();
+    }
+#endif
+    if (opcode != DL_FILL && opcode != DL_LINE)  size += sizeof(void *);
+    if (opcode == DL_IMAGE_MASKED)  size += sizeof(void *);
+    if (!LCD_ListBegin(list, opcode, size))  return;
+
+    LCD_ListPut16(list, Ctx->cursorPosX);
+    LCD_ListPut16(list, Ctx->cursorPosY);
+    LCD_ListPut16(list, w);
+    LCD_ListPut16(list, h);
+    if (opcode != DL_FILL && opcode != DL_LINE)  LCD_ListPutPtr(list, data1);
+    if (opcode == DL_IMAGE_MASKED)  LCD_ListPutPtr(list, data2);
+
+#ifdef LCD_PAGE_MODE
+    // An opaque fill may cover earlier calls, e.g. a text line cleared to be rewritten
+    if (list == &Ctx->screenList && opcode == DL_FILL && Ctx->pixelMode != FLIP_PIXELS
+        && Ctx->pixelMode != AND_PIXELS && list->length > list->size / 2)
+        LCD_CompactList(list);
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RecordText()
+ * Function           :  Record a string of chars shown at the current cursor position.
+ *                       The chars are copied into the list.
+ * Input              :  str = pointer to chars;  count = number of chars (0..255)
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RecordText(char *str, int count)
+{
+    displist_t  *list = LCD_GetRecorder(FALSE);
+
+    if (list == NULL || count == 0)  return;
+    if (!LCD_ListBegin(list, DL_TEXT, 6 + count))  return;
+
+    LCD_ListPut16(list, Ctx->cursorPosX);
+    LCD_ListPut16(list, Ctx->cursorPosY);
+    list->data[list->length++] = (uint8) count;
+    memcpy(&list->data[list->length], str, count);
+    list->length += count;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ReplayList()
+ *
+ * Function           :  Replay the calls recorded in a display list on the target, moved
+ *                       by dx pixels right and dy pixels down, e.g. to render one page of
+ *                       the screen on a surface 8 pixels high.  Calls which do not touch
+ *                       any row of the target are skipped.  The pixel mode, font and clip
+ *                       rectangle are changed as recorded.  The calls are recorded again,
+ *                       if a list is being recorded (or, in page mode, drawn on screen).
+ *
+ * Input              :  data = pointer to recorded calls
+ *                       length = number of bytes recorded
+ *                       dx, dy = offset added to each recorded position, pixels
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_ReplayList(uint8 *data, int length, int dx, int dy)
+{
+    uint8   *pData = data;
+    uint8   *pEnd = data + length;
+    uint8   opcode;
+    int     x, y, w, h;
+    int     sx = 0, sy = 0;
+    void    *data1, *data2;
+
+    while (pData < pEnd)
+    {
+        opcode = *pData++;
+
+        if (opcode == DL_MODE)  LCD_Mode(*pData++);
+        else if (opcode == DL_FONT)  LCD_SetFont(*pData++);
+        else if (opcode == DL_RESETCLIP)  LCD_ResetClip();
+        else if (opcode == DL_TEXT)
+        {
+            x = LCD_ListGet16(&pData) + dx;
+            y = LCD_ListGet16(&pData) + dy;
+            w = *pData++;           // number of chars
+            if (y < Ctx->target->height && (y + Ctx->fontSize) > 0)
+            {
+                LCD_PosXY(x, y);
+                LCD_ShowText((char *) pData, w);
+            }
+            pData += w;
+        }
+        else   // call with a block at (x, y), size w x h
+        {
+            x = LCD_ListGet16(&pData) + dx;
+            y = LCD_ListGet16(&pData) + dy;
+            w = LCD_ListGet16(&pData);
+            h = LCD_ListGet16(&pData);
+
+            if (opcode == DL_CLIP)  { LCD_SetClipRect(x, y, w, h);  continue; }
+            if (opcode == DL_LINE)   // from (x, y) to (w, h)
+            {
+                w += dx;
+                h += dy;
+                if ((y < Ctx->target->height || h < Ctx->target->height)
+                    && (y >= 0 || h >= 0))
+                {
+                    LCD_PosXY(x, y);
+                    LCD_DrawLine(w, h);
+                }
+                continue;
+            }
+
+            data1 = (opcode != DL_FILL) ? LCD_ListGetPtr(&pData) : NULL;
+            data2 = (opcode == DL_IMAGE_MASKED) ? LCD_ListGetPtr(&pData) : NULL;
+            if (opcode == DL_SURFACE)
+            {
+                sx = LCD_ListGet16(&pData);
+                sy = LCD_ListGet16(&pData);
+            }
+            if (y >= Ctx->target->height || (y + h) <= 0)  continue;   // no rows in target
+
+            LCD_PosXY(x, y);
+            if (opcode == DL_FILL)  LCD_BlockFill(w, h);
+            else if (opcode == DL_SURFACE)  LCD_PutSurface(data1, sx, sy, w, h);
+            else
+            {
+                LCD_RecordBlock(opcode, w, h, data1, data2);
+                LCD_BlitImage(data1, data2, w, h, FALSE);
+            }
+        }
+    }
+}
+
+
+#ifdef LCD_PAGE_MODE
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RecordState()
+ * Function           :  Record the current pixel mode, font and (if drawing on screen)
+ *                       clip rectangle in the screen list, so that the calls which follow
+ *                       are rendered with the same settings, e.g. after the screen list
+ *                       is cleared, or after settings were changed while recording
+ *                       another list.
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RecordState(void)
+{
+    LCD_RecordSetting(DL_MODE, Ctx->pixelMode);
+    LCD_RecordSetting(DL_FONT, LCD_GetFont());
+
+    if (Ctx->target != &Ctx->screen)  return;    // clip applies to off-screen surface
+
+    if (Ctx->clipLeft == 0 && Ctx->clipTop == 0 && Ctx->clipRight == Ctx->target->width
+        && Ctx->clipBottom == Ctx->target->height)  LCD_RecordSetting(DL_RESETCLIP, -1);
+    else  LCD_SetClipRect(Ctx->clipLeft, Ctx->clipTop, Ctx->clipRight - Ctx->clipLeft, Ctx->clipBottom - Ctx->clipTop);
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_CompactList()
+ *
+ * Function           :  Remove the calls from the screen list which no longer affect the
+ *                       screen, so that drawing can go on in page mode without the list
+ *                       overflowing, e.g. when lines of text are cleared and rewritten:
+ *
+ *                       - calls whose block lies within a later opaque fill (SET, COPY
+ *                         or CLEAR mode), within the clip rectangle of each;
+ *                       - calls which draw nothing (outside the clip rectangle), AND
+ *                         fills, and CLEAR fills before anything is drawn;
+ *                       - mode, font and clip changes which no call uses.
+ *
+ *                       The list is rewritten in place.  The time taken is proportional
+ *                       to the square of the number of calls in the list.  Called when
+ *                       the list is full, and after an opaque fill if over half full.
+ *
+ * Input              :  list = pointer to screen list
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_CompactList(displist_t *list)
+{
+    uint8   *pData = list->data;
+    uint8   *pEnd = list->data + list->length;
+    uint8   *pOut = list->data;     // end of compacted list (pOut <= pData)
+    liststate_t  state;             // state at pData, as replayed
+    liststate_t  emitted;           // state at pOut, as replayed from compacted list
+    int     area[4];                // left, top, right, bottom of pixels drawn by call
+    int     size;
+    bool    drawn = FALSE;          // TRUE once a call is kept
+    bool    keep;
+
+    memset(&state, 0, sizeof(state));
+    state.mode = 0xFF;
+    state.font = 0xFF;
+    state.clipLeft = 0;
+    state.clipTop = 0;
+    state.clipRight = LCD_WIDTH;
+    state.clipBottom = LCD_HEIGHT;
+    emitted = state;
+
+    for ( ;  pData < pEnd;  pData += size)
+    {
+        size = LCD_ListRecordSize(pData);
+        if (LCD_ListTrack(&state, pData))  continue;    // setting -- emitted when used
+
+        keep = LCD_ListArea(&state, pData, area)
+               && !LCD_ListCovered(&state, pData + size, pEnd, area);
+        if (*pData == DL_FILL && (state.mode == AND_PIXELS
+                                  || (state.mode == CLEAR_PIXELS && !drawn)))  keep = FALSE;
+        if (!keep)  continue;
+
+        pOut = LCD_ListEmitState(&state, &emitted, pOut);
+        memmove(pOut, pData, size);
+        pOut += size;
+        drawn = TRUE;
+    }
+
+    pOut = LCD_ListEmitState(&state, &emitted, pOut);   // settings for calls to come
+    list->length = pOut - list->data;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListRecordSize()
+ * Function           :  Return the size of a display list record, bytes, from its op-code
+ *                       (and char count, for text).
+ * Input              :  pData = pointer to record
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  int  LCD_ListRecordSize(uint8 *pData)
+{
+    switch (pData[0])
+    {
+    case DL_MODE:
+    case DL_FONT:          return 2;
+    case DL_RESETCLIP:     return 1;
+    case DL_TEXT:          return 6 + pData[5];
+    case DL_IMAGE:         return 9 + sizeof(void *);
+    case DL_IMAGE_MASKED:  return 9 + 2 * sizeof(void *);
+    case DL_SURFACE:       return 13 + sizeof(void *);
+    default:               return 9;   // DL_CLIP, DL_FILL, DL_LINE
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListTrack()
+ * Function           :  Apply a mode, font or clip record to the tracked state, as replay
+ *                       does (the clip rectangle is limited to the screen).
+ * Input              :  state = tracked state;  pData = pointer to record
+ * Return             :  TRUE if the record is a setting;  FALSE if it draws
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  bool  LCD_ListTrack(liststate_t *state, uint8 *pData)
+{
+    uint8   *p = pData + 1;
+    int     x, y, w, h;
+
+    if (*pData == DL_MODE)  state->mode = pData[1];
+    else if (*pData == DL_FONT)  state->font = pData[1];
+    else if (*pData == DL_RESETCLIP || *pData == DL_CLIP)
+    {
+        memcpy(state->clip, pData, LCD_ListRecordSize(pData));
+        x = 0;  y = 0;  w = LCD_WIDTH;  h = LCD_HEIGHT;
+        if (*pData == DL_CLIP)
+        {
+            x = LCD_ListGet16(&p);
+            y = LCD_ListGet16(&p);
+            w = LCD_ListGet16(&p);
+            h = LCD_ListGet16(&p);
+        }
+        state->clipLeft = (x < 0) ? 0 : (x < LCD_WIDTH) ? x : LCD_WIDTH;
+        state->clipTop = (y < 0) ? 0 : (y < LCD_HEIGHT) ? y : LCD_HEIGHT;
+        state->clipRight = ((x + w) < LCD_WIDTH) ? (x + w) : LCD_WIDTH;
+        state->clipBottom = ((y + h) < LCD_HEIGHT) ? (y + h) : LCD_HEIGHT;
+    }
+    else  return FALSE;
+
+    return TRUE;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListArea()
+ * Function           :  Find the area of the screen which a drawing record may modify:
+ *                       its block (a text line extends to the RH edge of the clip
+ *                       rectangle), within the clip rectangle.
+ * Input              :  state = state in effect at the record;  pData = pointer to record
+ * Output             :  area = left, top, right, bottom of area (right, bottom exclusive)
+ * Return             :  TRUE if the area is not empty
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  bool  LCD_ListArea(liststate_t *state, uint8 *pData, int *area)
+{
+    uint8   *p = pData + 1;
+    int     x = LCD_ListGet16(&p);
+    int     y = LCD_ListGet16(&p);
+    int     w, h;
+
+    if (*pData == DL_TEXT)
+    {
+        h = 24;                                       // font not known -- largest
+        if (state->font != 0xFF)  h = (state->font >= 12) ? 24 : 8 + 4 * (state->font >> 2);
+        area[0] = x;  area[1] = y;  area[2] = state->clipRight;  area[3] = y + h;
+    }
+    else
+    {
+        w = LCD_ListGet16(&p);
+        h = LCD_ListGet16(&p);
+        if (*pData == DL_LINE)   // from (x, y) to (w, h)
+        {
+            area[0] = MIN(x, w);  area[1] = MIN(y, h);
+            area[2] = ((x > w) ? x : w) + 1;  area[3] = ((y > h) ? y : h) + 1;
+        }
+        else
+        {
+            area[0] = x;  area[1] = y;  area[2] = x + (w & 0xFFFF);  area[3] = y + (h & 0xFFFF);
+        }
+    }
+
+    if (area[0] < state->clipLeft)  area[0] = state->clipLeft;
+    if (area[1] < state->clipTop)  area[1] = state->clipTop;
+    if (area[2] > state->clipRight)  area[2] = state->clipRight;
+    if (area[3] > state->clipBottom)  area[3] = state->clipBottom;
+
+    return  (area[0] < area[2] && area[1] < area[3]);
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListCovered()
+ * Function           :  Test whether an area is covered by an opaque fill (SET, COPY or
+ *                       CLEAR mode) in the records which follow.
+ * Input              :  state = state in effect at pData (not changed)
+ *                       pData, pEnd = records to be searched
+ *                       area = left, top, right, bottom of area (see LCD_ListArea)
+ * Return             :  TRUE if a later fill covers the area
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  bool  LCD_ListCovered(liststate_t *state, uint8 *pData, uint8 *pEnd, int *area)
+{
+    liststate_t  later = *state;
+    int     fill[4];
+
+    for ( ;  pData < pEnd;  pData += LCD_ListRecordSize(pData))
+    {
+        if (LCD_ListTrack(&later, pData) || *pData != DL_FILL)  continue;
+        if (later.mode == FLIP_PIXELS || later.mode == AND_PIXELS || later.mode == 0xFF)
+            continue;
+
+        if (LCD_ListArea(&later, pData, fill) && fill[0] <= area[0] && fill[1] <= area[1]
+            && fill[2] >= area[2] && fill[3] >= area[3])  return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_ListEmitState()
+ * Function           :  Write mode, font and clip records to the compacted list, for
+ *                       those settings which differ from the state already written.
+ * Input              :  state = state to be written;  emitted = state already written
+ *                       pOut = end of compacted list
+ * Return             :  new end of compacted list
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  uint8  *LCD_ListEmitState(liststate_t *state, liststate_t *emitted, uint8 *pOut)
+{
+    int     size = LCD_ListRecordSize(state->clip);
+
+    if (state->mode != emitted->mode)  { *pOut++ = DL_MODE;  *pOut++ = state->mode; }
+    if (state->font != emitted->font)  { *pOut++ = DL_FONT;  *pOut++ = state->font; }
+    if (state->clip[0] != 0 && memcmp(state->clip, emitted->clip, size) != 0)
+    {
+        memcpy(pOut, state->clip, size);
+        pOut += size;
+    }
+
+    *emitted = *state;
+    return  pOut;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RenderPage()
+ *
+ * Function           :  Render one page (8 rows) of the screen by replaying the screen
+ *                       display list on the strip buffer, then write the strip to the
+ *                       LCD module GDRAM.  The drawing state (target, pixel mode, font,
+ *                       cursor and clip rectangle) is restored afterwards.
+ *
+ * Input              :  page = page number, 0..7
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RenderPage(int page)
+{
+    surface_t  *target = Ctx->target;
+    uint8   mode = Ctx->pixelMode;
+    uint8   fontProp = Ctx->fontProp;
+    uint8   fontSize = Ctx->fontSize;
+    uint8   fontWeight = Ctx->fontWeight;
+    int16   posX = Ctx->cursorPosX;
+    int16   posY = Ctx->cursorPosY;
+    int     clipLeft = Ctx->clipLeft;
+    int     clipTop = Ctx->clipTop;
+    int     clipRight = Ctx->clipRight;
+    int     clipBottom = Ctx->clipBottom;
+
+    memset(Ctx->stripBuffer, 0, sizeof(Ctx->stripBuffer));
+    Ctx->target = &Ctx->strip;
+    Ctx->renderingPage = TRUE;
+    LCD_ResetClip();
+    Ctx->pixelMode = SET_PIXELS;
+
+    LCD_ReplayList(Ctx->screenList.data, Ctx->screenList.length, 0, -page * 8);
+
+    Ctx->renderingPage = FALSE;
+    Ctx->target = target;
+    Ctx->pixelMode = mode;
+    Ctx->fontProp = fontProp;
+    Ctx->fontSize = fontSize;
+    Ctx->fontWeight = fontWeight;
+    Ctx->cursorPosX = posX;
+    Ctx->cursorPosY = posY;
+    Ctx->clipLeft = clipLeft;
+    Ctx->clipTop = clipTop;
+    Ctx->clipRight = clipRight;
+    Ctx->clipBottom = clipBottom;
+
+    Ctx->driver->writeStrip(Ctx->stripBuffer, page);
+}
+#endif  // LCD_PAGE_MODE
+
+
+#ifdef LCD_ROTATION
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RotateBlock()
+ * Function           :  Convert a block in (rotated) screen coords to panel coords.
+ * Input              :  x, y, w, h = pointers to block position and size, pixels
+ * Return             :  (x, y, w, h) updated
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RotateBlock(int *x, int *y, int *w, int *h)
+{
+    int     x0 = *x, y0 = *y, w0 = *w, h0 = *h;
+
+    if (Ctx->rotation == ROTATE_90)         // panel (px, py) shows screen (py, W-1-px)
+    {
+        *x = LCD_WIDTH - (y0 + h0);
+        *y = x0;
+        *w = h0;
+        *h = w0;
+    }
+    else if (Ctx->rotation == ROTATE_180)   // panel (px, py) shows (W-1-px, H-1-py)
+    {
+        *x = LCD_WIDTH - (x0 + w0);
+        *y = LCD_HEIGHT - (y0 + h0);
+    }
+    else  // ROTATE_270                     // panel (px, py) shows screen (H-1-py, px)
+    {
+        *x = y0;
+        *y = LCD_HEIGHT - (x0 + w0);
+        *w = h0;
+        *h = w0;
+    }
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_RenderRotatedPage()
+ *
+ * Function           :  Render one page (8 rows) of the panel from the rotated screen
+ *                       buffer into the rotation strip, then write the strip to the LCD
+ *                       module GDRAM.  Each block of 8 x 8 pixels on the panel is taken
+ *                       from one block of 8 x 8 pixels in the screen buffer, packed in a
+ *                       64-bit word, and rotated by flipping the bit matrix about its
+ *                       diagonal, rows or columns -- a few masked shifts per block,
+ *                       instead of computing the coordinates of each pixel.
+ *
+ * Input              :  page = page number on panel, 0..LCD_PAGES-1
+ * Return             :  --
+ *--------------------------------------------------------------------------------------*/
+PRIVATE  void  LCD_RenderRotatedPage(int page)
+{
+    surface_t  *src = &Ctx->screen;
+    int     col;                    // block column on panel (8 pixels)
+    uint64  block;
+
+    for (col = 0;  col < LCD_WIDTH / 8;  col++)
+    {
+        if (Ctx->rotation == ROTATE_90)
+        {
+            block = LCD_GetBlock8x8(src->bits, src->stride, page * 8, LCD_WIDTH - 8 - col * 8);
+            block = LCD_FlipRows8x8(LCD_FlipDiagonal8x8(block));
+        }
+        else if (Ctx->rotation == ROTATE_180)
+        {
+            block = LCD_GetBlock8x8(src->bits, src->stride, LCD_WIDTH - 8 - col * 8,
+                                    LCD_HEIGHT - 8 - page * 8);
+            block = LCD_FlipCols8x8(LCD_FlipRows8x8(block));
+        }
+        else  // ROTATE_270
+        {
+            block = LCD_GetBlock8x8(src->bits, src->stride, LCD_HEIGHT - 8 - page * 8, col * 8);
+            block = LCD_FlipCols8x8(LCD_FlipDiagonal8x8(block));
+        }
+
+        LCD_PutBlock8x8(Ctx->rotStrip, SURFACE_WORDS(LCD_WIDTH, 1), col * 8, block);
+    }
+
+    Ctx->driver->writeStrip(Ctx->rotStrip, page);
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_GetBlock8x8()
+ *
+ * Function           :  Fetch a block of 8 x 8 pixels from a buffer in screen buffer
+ *                       format.  The block is returned as 8 bytes, byte N (bits 8N+7..8N)
+ *                       holding row N, bit 7 at LHS.  If the buffer is page-major, byte N
+ *                       holds column N, bit 0 at the top, i.e. the block is in the same
+ *                       layout rotated 90 degrees;  rotation (unlike a flip) is the same
+ *                       operation in either layout, so the caller need not distinguish.
+ *
+ * Input              :  bits, stride = buffer address and stride (see surface_t)
+ *                       x, y = pixel coords of upper LHS of block (multiples of 8)
+ * Return             :  8 x 8 pixels
+ *--------------------------------------------------------------------------------------*/
+INLINE  uint64  LCD_GetBlock8x8(scnword_t *bits, int stride, int x, int y)
+{
+    uint64  block = 0;
+    int     i;
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    uint8   *pBuf = bits + (y / 8) * stride + x;
+
+    for (i = 0;  i < 8;  i++)  block |= (uint64) pBuf[i] << (i * 8);
+#else
+    scnword_t  *pBuf = bits + y * stride + x / SCN_WORD_BITS;
+    int     shift = SCN_WORD_BITS - 8 - x % SCN_WORD_BITS;
+
+    for (i = 0;  i < 8;  i++, pBuf += stride)
+    {
+        block |= (uint64) ((*pBuf >> shift) & 0xFF) << (i * 8);
+    }
+#endif
+    return  block;
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_PutBlock8x8()
+ * Function           :  Store a block of 8 x 8 pixels (see LCD_GetBlock8x8) in one page
+ *                       (8 rows) of a buffer in screen buffer format.
+ * Input              :  bits, stride = buffer address and stride (see surface_t)
+ *                       x = pixel x-coord of LHS of block (multiple of 8)
+ *                       block = 8 x 8 pixels
+ *--------------------------------------------------------------------------------------*/
+INLINE  void  LCD_PutBlock8x8(scnword_t *bits, int stride, int x, uint64 block)
+{
+    int     i;
+#ifdef LCD_BUFFER_PAGE_MAJOR
+    uint8   *pBuf = bits + x;
+
+    (void) stride;   // the page is one row of bytes
+    for (i = 0;  i < 8;  i++, block >>= 8)  pBuf[i] = (uint8) block;
+#else
+    scnword_t  *pBuf = bits + x / SCN_WORD_BITS;
+    int     shift = SCN_WORD_BITS - 8 - x % SCN_WORD_BITS;
+    scnword_t  mask = ~((scnword_t) 0xFF << shift);
+
+    for (i = 0;  i < 8;  i++, pBuf += stride, block >>= 8)
+    {
+        *pBuf = (*pBuf & mask) | ((scnword_t) (block & 0xFF) << shift);
+    }
+#endif
+}
+
+
+/*----------------------------------------------------------------------------------------
+ * Name               :  LCD_FlipDiagonal8x8(), LCD_FlipRows8x8(), LCD_FlipCols8x8()
+ *
+ * Function           :  Flip a block of 8 x 8 pixels (see LCD_GetBlock8x8) about its
+ *                       diagonal from upper RHS to lower LHS, i.e. pixel (x, y) moves
+ *                       to (7-y, 7-x);  or upside down (reverse the order of the rows);
+ *                       or left-to-right (reverse the bits in each row).  Each takes 3
+ *                       stages of masked bit swaps.  Rotations are combinations of two:
+ *                       90 degrees clockwise = diagonal then rows;  180 = rows then
+ *                       cols;  270 = diagonal then cols.
+ *
+ * Input              :  block = 8 x 8 pixels
+ * Return             :  8 x 8 pixels, flipped
+ *--------------------------------------------------------------------------------------*/
+INLINE  uint64  LCD_FlipDiagonal8x8(uint64 block)
+{
+    uint64  t;
+
+    t = (block ^ (block >> 7)) & 0x00AA00AA00AA00AAULL;  block ^= t ^ (t << 7);   // 1 x 1
+    t = (block ^ (block >> 14)) & 0x0000CCCC0000CCCCULL;  block ^= t ^ (t << 14);  // 2 x 2
+    t = (block ^ (block >> 28)) & 0x00000000F0F0F0F0ULL;  block ^= t ^ (t << 28);  // 4 x 4
+
+    return  block;
+}
+
+INLINE  uint64  LCD_FlipRows8x8(uint64 block)
+{
+    block = (block << 32) | (block >> 32);
+    block = ((block & 0x0000FFFF0000FFFFULL) << 16) | ((block >> 16) & 0x0000FFFF0000FFFFULL);
+    block = ((block & 0x00FF00FF00FF00FFULL) << 8) | ((block >> 8) & 0x00FF00FF00FF00FFULL);
+
+    return  block;
+}
+
+INLINE  uint64  LCD_FlipCols8x8(uint64 block)
+{
+    block = ((block & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((block >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+    block = ((block & 0x3333333333333333ULL) << 2) | ((block >> 2) & 0x3333333333333333ULL);
+    block = ((block & 0x5555555555555555ULL) << 1) | ((block >> 1) & 0x5555555555555555ULL);
+
+    return  block;
 }
+#endif  // LCD_ROTATION
 
 // END-OF-FILE
@@ -1,7 +1,8 @@
 /*
  * File: LCD_graphics_lib.h
  *
- * API Library definitions for Monochrome Graphic LCD module, 128 x 64 pixels.
+ * API Library definitions for Monochrome Graphic LCD module, 128 x 64 pixels
+ * (or other size -- see LCD_WIDTH, LCD_HEIGHT in LCD_buffer_def.h).
  */
  
 #ifndef LCD_GRAPHICS_LIB_H
@@ -9,6 +10,7 @@
 
 #include "../Common/system_def.h"
 #include "HardwareProfile.h"
+#include "../Drivers/LCD_buffer_def.h"
 
 // Determine LCD controller device based on def's in HardwareProfile.h
 #ifdef USE_LCD_CONTROLLER_ST7920 
@@ -26,6 +28,14 @@
 #define CLEAR_PIXELS          0
 #define SET_PIXELS            1
 #define FLIP_PIXELS           2
+#define COPY_PIXELS           3     // Opaque -- image 0's clear pixels, 1's set pixels
+#define AND_PIXELS            4     // Image 0's clear pixels, 1's leave pixels unchanged
+
+// Screen rotation (clockwise) for LCD_SetRotation() -- requires option LCD_ROTATION
+#define ROTATE_0              0
+#define ROTATE_90             1     // Portrait -- screen is LCD_HEIGHT x LCD_WIDTH
+#define ROTATE_180            2
+#define ROTATE_270            3     // Portrait
 
 // Character font styles;  size is cell height in pixels.
 // Use one of the font names defined here as the arg value in function: LCD_SetFont(arg).
@@ -58,23 +68,175 @@ enum  Graphics_character_fonts
 
 typedef  const unsigned char  bitmap_t;  // Bitmap image is an array of bytes in flash
 
+// Off-screen drawing surface -- pixel buffer in the same format as the screen buffer
+typedef  struct
+{
+    uint16     width;         // Surface width, pixels
+    uint16     height;        // Surface height, pixels
+    uint16     stride;        // Column-words per row (or bytes per page, if page-major)
+    scnword_t  *bits;         // Pixel buffer, SURFACE_WORDS(width, height) words
+} surface_t;
+
+// Size of pixel buffer (number of scnword_t) needed for a surface of w x h pixels
+#ifdef LCD_BUFFER_PAGE_MAJOR
+#define SURFACE_WORDS(w, h)   ((((h) + 7) / 8) * (w))
+#else
+#define SURFACE_WORDS(w, h)   ((h) * (((w) + SCN_WORD_BITS - 1) / SCN_WORD_BITS))
+#endif
+
+// Saved region of the screen (or other surface) -- see LCD_SaveRegion()
+typedef  struct
+{
+    surface_t  *target;       // Surface from which the pixels were saved
+    uint16     x, y, w, h;    // Position and size of region, pixels
+    surface_t  saved;         // Saved pixels (aligned to words of the target)
+    int        poolOffset;    // Offset of buffer in region pool;  -1 if caller's buffer
+} region_t;
+
+// Collision report of the last LCD_PutImage() or LCD_PutImageMasked() -- see LCD_GetCollision()
+typedef  struct
+{
+    uint16     count;         // Number of image pixels which fell on pixels already set
+    int16      left;          // Bounding box of those pixels:  left <= x < right
+    int16      top;           // and top <= y < bottom  (all 0 if count is 0)
+    int16      right;
+    int16      bottom;
+} collision_t;
+
+// Size of buffer (number of scnword_t) needed to save a region of w x h pixels
+#ifdef LCD_BUFFER_PAGE_MAJOR
+#define REGION_WORDS(w, h)    SURFACE_WORDS((w), (h) + 7)
+#else
+#define REGION_WORDS(w, h)    SURFACE_WORDS((w) + SCN_WORD_BITS - 1, (h))
+#endif
+
+// Size of pool (scnword_t) from which LCD_SaveRegion() allocates buffers, if the caller
+// does not supply one.  The default is half the size of the screen buffer (none in page
+// mode, which has no screen buffer to save).
+#ifndef LCD_REGION_POOL_WORDS
+#ifdef LCD_PAGE_MODE
+#define LCD_REGION_POOL_WORDS   0
+#else
+#define LCD_REGION_POOL_WORDS   (SURFACE_WORDS(LCD_WIDTH, LCD_HEIGHT) / 2)
+#endif
+#endif
+
+// Display list -- a sequence of recorded drawing calls (see LCD_BeginRecord).
+// Each call takes a few bytes:  mode or font 2, fill 9, image 13 (32-bit MCU),
+// masked image 17, surface 17, text 6 + number of chars.
+typedef  struct
+{
+    uint8      *data;         // Buffer for recorded calls
+    uint16     size;          // Buffer size, bytes
+    uint16     length;        // Number of bytes recorded
+    bool       full;          // True => a call did not fit (and later calls were lost)
+} displist_t;
+
+// Size of display list (bytes) which records the calls that draw the screen, in page
+// mode (LCD_PAGE_MODE).  Calls drawn over later are removed when the list fills up;  if
+// it still overflows, later calls are lost and LCD_Flush() returns FALSE.
+#ifndef LCD_DISPLAY_LIST_SIZE
+#define LCD_DISPLAY_LIST_SIZE   256
+#endif
+
+// Size of screen buffer (number of scnword_t).  With rotation, the buffer holds the
+// screen in either orientation (LCD_WIDTH x LCD_HEIGHT, or LCD_HEIGHT x LCD_WIDTH).
+#if defined LCD_ROTATION && SURFACE_WORDS(LCD_HEIGHT, LCD_WIDTH) > SURFACE_WORDS(LCD_WIDTH, LCD_HEIGHT)
+#define LCD_SCREEN_WORDS   SURFACE_WORDS(LCD_HEIGHT, LCD_WIDTH)
+#else
+#define LCD_SCREEN_WORDS   SURFACE_WORDS(LCD_WIDTH, LCD_HEIGHT)
+#endif
+
+// LCD controller driver -- functions which write the screen buffer to an LCD module.
+// The default display context uses the driver module linked with the library.
+typedef  struct
+{
+    void  (*clearGDRAM)(void);
+    void  (*writeBlock)(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+#if defined LCD_PAGE_MODE || defined LCD_ROTATION
+    void  (*writeStrip)(scnword_t *strip, uint8 page);
+#endif
+} lcddriver_t;
+
+// Batch mode tracks modified areas of the screen in tiles of 16 x 8 pixels, or 32 x 8
+// if the screen has more than 64 tiles of 16 x 8 (one bit each in a 64-bit word).
+#if ((LCD_WIDTH + 15) / 16) * LCD_PAGES <= 64
+#define LCD_TILE_WIDTH   16
+#else
+#define LCD_TILE_WIDTH   32
+#endif
+#define LCD_TILE_COLS    ((LCD_WIDTH + LCD_TILE_WIDTH - 1) / LCD_TILE_WIDTH)
+#define LCD_ALL_TILES    (~(uint64) 0 >> (64 - LCD_TILE_COLS * LCD_PAGES))   // all dirty
+
+// Display context -- screen buffer and drawing state of one display (see LCD_InitContext).
+// All API functions act on the selected context.  Members are private to the library.
+typedef  struct
+{
+    const lcddriver_t  *driver;   // LCD module driver;  NULL if the screen is not shown
+#ifdef LCD_PAGE_MODE
+    scnword_t  stripBuffer[LCD_WIDTH];      // 1 page x 128 cols x 8 pixels (vertical)
+    surface_t  strip;                       // One page of the screen, rendered from list
+    uint8      screenListData[LCD_DISPLAY_LIST_SIZE];
+    displist_t  screenList;                 // Calls which draw the screen
+    bool       renderingPage;               // True => replaying screen list
+#else
+    scnword_t  screenBuffer[LCD_SCREEN_WORDS];   // 8 pages x 128 cols, or 64 rows x 8 cols
+#endif
+#ifdef LCD_ROTATION
+    scnword_t  rotStrip[SURFACE_WORDS(LCD_WIDTH, 8)];   // 1 page of panel, rotated
+    uint8      rotation;      // Screen rotation (ROTATE_0, ROTATE_90, etc)
+#endif
+    surface_t  screen;        // The screen buffer, as a drawing surface
+    surface_t  *target;       // Surface modified by drawing functions
+    uint8      pixelMode;     // Pixel writing mode (see LCD_Mode fn)
+    int16      cursorPosX;    // Graphics cursor position (may be off-screen)
+    int16      cursorPosY;
+    uint8      fontProp;      // Font style (0: monospaced, 1: proportional)
+    uint8      fontSize;      // Char cell height (pixels)
+    uint8      fontWeight;    // 0 = Normal;  1 = Bold
+    int        clipLeft;      // Clip rectangle -- drawing functions modify pixels
+    int        clipTop;       // (x, y) only where clipLeft <= x < clipRight
+    int        clipRight;     // and clipTop <= y < clipBottom
+    int        clipBottom;
+#if LCD_REGION_POOL_WORDS > 0
+    scnword_t  regionPool[LCD_REGION_POOL_WORDS];   // Buffers for saved regions
+#endif
+    int        regionPoolUsed;   // Number of pool words allocated (from start of pool)
+    bool       batchMode;     // True => GDRAM update deferred until LCD_Flush()
+    uint64     dirtyTiles;    // Tiles modified since last flush;  bit (page * LCD_TILE_COLS
+                              // + col) is set if the tile at (col, page) is dirty
+    bool       panelBlank;    // True => GDRAM known to be clear (see LCD_ClearScreen)
+    displist_t  *recording;   // List being recorded (see LCD_BeginRecord fn)
+    collision_t  collision;   // Collision report of last image drawn (see LCD_GetCollision)
+} lcdcontext_t;
+
 
 //---------- Controller low-level functions, defined in driver module -------------------
 //
 extern  bool  LCD_Init(void);      // LCD controller initialisation
 extern  void  LCD_ClearGDRAM();
-extern  void  LCD_WriteBlock(uint16 *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+extern  void  LCD_WriteBlock(scnword_t *scnBuf, uint16 x, uint16 y, uint16 w, uint16 h);
+#if defined LCD_PAGE_MODE || defined LCD_ROTATION
+extern  void  LCD_WriteStrip(scnword_t *strip, uint8 page);   // 1 page, LCD_WIDTH x 8
+#endif
 
 //---------- LCD function & macro library (API) -----------------------------------------
 //
-#define LCD_GetMaxX()       (127)
-#define LCD_GetMaxY()       (63)
+#ifdef LCD_ROTATION
+int16   LCD_GetMaxX(void);                // Screen width - 1 (depends on rotation)
+int16   LCD_GetMaxY(void);                // Screen height - 1
+void    LCD_SetRotation(uint8 rotation);  // Rotate screen (ROTATE_90, etc) and clear
+uint8   LCD_GetRotation(void);            // Get screen rotation
+#else
+#define LCD_GetMaxX()       (LCD_WIDTH - 1)
+#define LCD_GetMaxY()       (LCD_HEIGHT - 1)
+#endif
 
 void    LCD_ClearScreen(void);            // Clear LCD GDRAM and MCU RAM buffers
 void    LCD_Mode(uint8 mode);             // Set pixel write mode (set, clear, flip)
-void    LCD_PosXY(uint16 x, uint16 y);    // Set graphics cursor position to (x, y)
-uint16  LCD_GetX(void);                   // Get graphics cursor pos x-coord
-uint16  LCD_GetY(void);                   // Get graphics cursor pos y-coord
+void    LCD_PosXY(int16 x, int16 y);      // Set graphics cursor position to (x, y)
+int16   LCD_GetX(void);                   // Get graphics cursor pos x-coord
+int16   LCD_GetY(void);                   // Get graphics cursor pos y-coord
 void    LCD_SetFont(uint8 font_ID);       // Set font for char or text display
 uint8   LCD_GetFont();                    // Get current font ID
 void    LCD_PutChar(char uc);             // Show ASCII char at (x, y)
@@ -83,9 +245,38 @@ void    LCD_PutDigit(uint8 bDat);         // Show hex/decimal digit value (1 cha
 void    LCD_PutHexByte(uint8 bDat);       // Show hexadecimal byte value (2 chars)
 
 void    LCD_PutDecimalWord(uint16 val, uint8 fieldSize);  // Show uint16 in decimal
+void    LCD_SetClip(uint16 x, uint16 y, uint16 w, uint16 h);  // Limit drawing to area
+void    LCD_ResetClip(void);              // Remove clip rectangle (whole target)
 void    LCD_BlockFill(uint16 w, uint16 h);   // Fill area, w x h pixels, at cursor (x, y)
+void    LCD_DrawLine(int16 x1, int16 y1);    // Draw line from cursor (x, y) to (x1, y1)
+void    LCD_FillScreen(void);             // Fill whole target (within clip) in current mode
+void    LCD_InvertScreen(void);           // Flip all pixels of target (within clip)
+uint32  LCD_CountScreenPixels(void);      // Count pixels set in whole target
+bool    LCD_CompareScreen(surface_t *src);   // TRUE if target and surface are the same
+uint8   LCD_GetPixel(int16 x, int16 y);   // Read pixel at (x, y):  1 = set
+uint32  LCD_CountPixels(int16 x, int16 y, uint16 w, uint16 h);   // Count pixels set in area
+uint8   LCD_TestImage(bitmap_t *image, int16 x, int16 y, uint16 w, uint16 h);  // Collision?
 uint8   LCD_PutImage(bitmap_t *image, uint16 w, uint16 h);  // Show bitmap image at (x, y)
-uint16 *LCD_ScreenCapture();              // Return a pointer to the screen buffer
+void    LCD_DrawImage(bitmap_t *image, uint16 w, uint16 h);  // Same, no collision test
+uint8   LCD_PutImageMasked(bitmap_t *image, bitmap_t *mask, uint16 w, uint16 h);  // Transparent
+void    LCD_GetCollision(collision_t *info);   // Overlap count and box of last image
+scnword_t *LCD_ScreenCapture();           // Return a pointer to the screen buffer
+void    LCD_BeginBatch(void);             // Defer GDRAM update until LCD_Flush()
+bool    LCD_Flush(void);                  // Write pending changes to GDRAM, end batch
+
+void    LCD_InitSurface(surface_t *surface, scnword_t *bits, uint16 w, uint16 h);  // and clear
+void    LCD_SetTarget(surface_t *surface);   // Draw to surface (NULL: screen)
+surface_t *LCD_GetTarget();               // Return surface being drawn to
+void    LCD_PutSurface(surface_t *src, uint16 sx, uint16 sy, uint16 w, uint16 h);  // Blit
+void    LCD_ScrollRegion(uint16 w, uint16 h, int dx, int dy);  // Move pixels in block at (x, y)
+bool    LCD_SaveRegion(region_t *region, scnword_t *buffer, uint16 x, uint16 y,
+                       uint16 w, uint16 h);     // Save pixels in area w x h at (x, y)
+void    LCD_RestoreRegion(region_t *region);    // Restore saved pixels, update display
+void    LCD_BeginRecord(displist_t *list, uint8 *buffer, uint16 size);  // Record, don't draw
+bool    LCD_EndRecord(void);              // Stop recording;  FALSE if list overflowed
+void    LCD_Replay(displist_t *list, int16 dx, int16 dy);  // Draw recorded calls, offset
+void    LCD_InitContext(lcdcontext_t *ctx, const lcddriver_t *driver);  // New display
+lcdcontext_t *LCD_SelectContext(lcdcontext_t *ctx);   // Bind context (NULL: default)
 
 // These macros draw various objects at the current graphics cursor position...
 #define LCD_PutPixel()           LCD_BlockFill(1, 1)
@@ -96,8 +287,8 @@ uint16 *LCD_ScreenCapture();              // Return a pointer to the screen buff
 
 //---------- Aliases for OLED (or other 128 x 64 pixel display) ----------------------------
 //
-#define Disp_GetMaxX()      (127)                   // Screen width, pixels
-#define Disp_GetMaxY()      (63)                    // Screen height, pixels
+#define Disp_GetMaxX()      LCD_GetMaxX()           // Screen width - 1, pixels
+#define Disp_GetMaxY()      LCD_GetMaxY()           // Screen height - 1, pixels
 #define Disp_Init()         LCD_Init()              // Controller initialisation
 #define Disp_ClearScreen()  LCD_ClearScreen()       // Clear GDRAM and MCU RAM buffers
 #define Disp_Mode(mode)     LCD_Mode(mode)          // Set pixel write mode (set, clear, flip)
@@ -112,9 +303,40 @@ uint16 *LCD_ScreenCapture();              // Return a pointer to the screen buff
 #define Disp_PutHexByte(h)  LCD_PutHexByte(h)       // Show hexadecimal byte (2 chars)
 
 #define Disp_PutDecimal(w, n)     LCD_PutDecimalWord(w, n)  // Show uint16 in decimal (n places)
+#define Disp_SetClip(x, y, w, h)  LCD_SetClip(x, y, w, h)   // Limit drawing to area
+#define Disp_ResetClip()          LCD_ResetClip()           // Remove clip rectangle
 #define Disp_BlockFill(w, h)      LCD_BlockFill(w, h)       // Fill area w x h pixels at (x, y)
+#define Disp_DrawLine(x1, y1)     LCD_DrawLine(x1, y1)      // Draw line from (x, y) to (x1, y1)
+#define Disp_FillScreen()         LCD_FillScreen()          // Fill whole screen in current mode
+#define Disp_InvertScreen()       LCD_InvertScreen()        // Flip all pixels, e.g. flash
+#define Disp_CountScreenPixels()  LCD_CountScreenPixels()   // Count pixels set
+#define Disp_CompareScreen(s)     LCD_CompareScreen(s)      // TRUE if surface is the same
+#define Disp_GetPixel(x, y)       LCD_GetPixel(x, y)        // Read pixel at (x, y)
+#define Disp_CountPixels(x, y, w, h)      LCD_CountPixels(x, y, w, h)  // Count pixels in area
+#define Disp_TestImage(img, x, y, w, h)   LCD_TestImage(img, x, y, w, h)  // Collision test
 #define Disp_PutImage(img, w, h)  LCD_PutImage(img, w, h)   // Show bitmap image at (x, y)
+#define Disp_DrawImage(img, w, h) LCD_DrawImage(img, w, h)  // Same, no collision test
+#define Disp_PutImageMasked(img, mask, w, h)  LCD_PutImageMasked(img, mask, w, h)
+#define Disp_GetCollision(info)   LCD_GetCollision(info)    // Overlap count and box of last image
 #define Disp_ScreenCapture()      LCD_ScreenCapture()       // Return a pointer to the screen buffer
+#define Disp_BeginBatch()         LCD_BeginBatch()          // Defer GDRAM update until flush
+#define Disp_Flush()              LCD_Flush()               // Write pending changes to GDRAM
+#define Disp_InitSurface(s, b, w, h)      LCD_InitSurface(s, b, w, h)  // Init off-screen surface
+#define Disp_SetTarget(s)                 LCD_SetTarget(s)      // Draw to surface (NULL: screen)
+#define Disp_GetTarget()                  LCD_GetTarget()       // Return surface being drawn to
+#define Disp_PutSurface(s, sx, sy, w, h)  LCD_PutSurface(s, sx, sy, w, h)  // Blit surface block
+#define Disp_ScrollRegion(w, h, dx, dy)   LCD_ScrollRegion(w, h, dx, dy)  // Scroll block
+#define Disp_SaveRegion(r, buf, x, y, w, h)  LCD_SaveRegion(r, buf, x, y, w, h)  // Save area
+#define Disp_RestoreRegion(r)             LCD_RestoreRegion(r)  // Restore saved area
+#define Disp_BeginRecord(l, buf, size)    LCD_BeginRecord(l, buf, size)  // Record calls
+#define Disp_EndRecord()                  LCD_EndRecord()       // Stop recording
+#define Disp_Replay(l, dx, dy)            LCD_Replay(l, dx, dy)  // Draw recorded calls
+#define Disp_InitContext(c, drv)          LCD_InitContext(c, drv)  // Init display context
+#define Disp_SelectContext(c)             LCD_SelectContext(c)  // Bind display context
+#ifdef LCD_ROTATION
+#define Disp_SetRotation(r)               LCD_SetRotation(r)    // Rotate screen (and clear)
+#define Disp_GetRotation()                LCD_GetRotation()     // Get screen rotation
+#endif
 
 #define Disp_PutPixel()           LCD_BlockFill(1, 1)
 #define Disp_DrawBar(w, h)        LCD_BlockFill(w, h)
@@ -76,6 +76,7 @@ int main(void)
     putstr("* Press 'user' button to show next test screen, or...\n");
     putstr("* type a text line here to display on the OLED screen.\n");
     putstr("* To set font, enter: `n  (where n is the font ID code).\n");
+    putstr("* To run the graphics benchmark, enter: #\n");
     putstr("> ");
 
     Disp_Init();
@@ -100,7 +101,8 @@ int main(void)
         if (isButtonHit)
         {
             isButtonHit = 0;
-            Disp_ClearScreen();
+            Disp_BeginBatch();  // send each screen to the display in one update
+            Disp_ClearScreen();  // cleared with the new screen at Disp_Flush()
 
             if (screen == 0) DisplayHomeMessageScreen();
             if (screen == 1) DisplayTheQuickBrownFox();
@@ -111,12 +113,17 @@ int main(void)
             if (screen == 6) TestImagesScreenOne();
             if (screen == 7) TestImagesScreenTwo();
 
+            Disp_Flush();
             if (++screen >= 8) screen = 0; // repeat test sequence
         }
         
         if (getString(inbuf, 40))  // have string from terminal...
         {
-            if (inbuf[0] == '`')  // command message -- set font
+            if (inbuf[0] == '#')  // command message -- run benchmark
+            {
+                RunBenchmark();
+            }
+            else if (inbuf[0] == '`')  // command message -- set font
             {
                 fontID = atoi(&inbuf[1]) & 0xF;
                 fontSize = 8 + 4 * (fontID >> 2);   // b3:b2 (0: 8p, 1: 12p, 2: 16p, 3: 24p)
@@ -132,13 +139,13 @@ int main(void)
                 Disp_SetFont(fontID); 
                 Disp_PosXY(0, nextLine_ypos);
                 Disp_Mode(CLEAR_PIXELS);
-                Disp_BlockFill(128, 64);
+                Disp_BlockFill(Disp_GetMaxX() + 1, Disp_GetMaxY() + 1);
                 Disp_PosXY(0, nextLine_ypos);
                 Disp_Mode(SET_PIXELS);
                 Disp_PutText(inbuf);
                 
                 nextLine_ypos += lineSpacing; 
-                if (nextLine_ypos + fontSize >= 64)  nextLine_ypos = 0; //wrap to top
+                if (nextLine_ypos + fontSize > Disp_GetMaxY())  nextLine_ypos = 0; //wrap to top
             }
             else  nextLine_ypos = 0;
             
@@ -148,22 +155,35 @@ int main(void)
 }
 
 
+// The home screen is the same every time, so it is recorded in a display list on the
+// first call, then drawn from the list, without repeating the font expansion.
+//
 void DisplayHomeMessageScreen()
 {
-    Disp_Mode(SET_PIXELS);
+    static displist_t  homeScreenList;
+    static uint8  homeScreenData[80];
 
-    Disp_PosXY(0, 0);
-    Disp_DrawLineHoriz(128);
-    Disp_PosXY(0, 63);
-    Disp_DrawLineHoriz(128);
-    Disp_PosXY(0, 0);
-    Disp_DrawLineVert(64);
-    Disp_PosXY(127, 0);
-    Disp_DrawLineVert(64);
+    if (homeScreenList.length == 0)
+    {
+        Disp_BeginRecord(&homeScreenList, homeScreenData, sizeof(homeScreenData));
+        Disp_Mode(SET_PIXELS);
+
+        Disp_PosXY(0, 0);
+        Disp_DrawLineHoriz(Disp_GetMaxX() + 1);
+        Disp_PosXY(0, Disp_GetMaxY());
+        Disp_DrawLineHoriz(Disp_GetMaxX() + 1);
+        Disp_PosXY(0, 0);
+        Disp_DrawLineVert(Disp_GetMaxY() + 1);
+        Disp_PosXY(Disp_GetMaxX(), 0);
+        Disp_DrawLineVert(Disp_GetMaxY() + 1);
+
+        Disp_SetFont(PROP_12_NORM);
+        Disp_PosXY(18, 24);
+        Disp_PutText("Hello, world!");
+        Disp_EndRecord();
+    }
 
-    Disp_SetFont(PROP_12_NORM);
-    Disp_PosXY(18, 24);
-    Disp_PutText("Hello, world!");
+    Disp_Replay(&homeScreenList, 0, 0);
 }
 
 void DisplayTheQuickBrownFox()
@@ -195,7 +215,35 @@ void DisplayTheQuickBrownFox()
     }
 }
 
+// This screen is also static, so it is rendered once into an off-screen surface (cache),
+// then copied to the screen by a single surface blit.  In page mode there is no RAM to
+// spare for the cache, so the screen is drawn directly.
+//
 void TestImagesScreenOne()
+{
+#ifdef LCD_PAGE_MODE
+    DrawImagesScreenOne();
+#else
+    static surface_t  screenCache;
+    static scnword_t  screenCacheBits[SURFACE_WORDS(LCD_WIDTH, LCD_HEIGHT)];
+    static bool  isCached;
+
+    if (!isCached)
+    {
+        Disp_InitSurface(&screenCache, screenCacheBits, LCD_WIDTH, LCD_HEIGHT);
+        Disp_SetTarget(&screenCache);
+        DrawImagesScreenOne();
+        Disp_SetTarget(NULL);
+        isCached = TRUE;
+    }
+
+    Disp_Mode(SET_PIXELS);
+    Disp_PosXY(0, 0);
+    Disp_PutSurface(&screenCache, 0, 0, LCD_WIDTH, LCD_HEIGHT);
+#endif
+}
+
+void DrawImagesScreenOne()
 {
     Disp_Mode(SET_PIXELS);
 
@@ -245,6 +293,72 @@ void TestImagesScreenTwo()
 }
 
 
+
+// Function to measure the execution time of the graphics primitives, used to compare
+// screen buffer formats (see LCD_buffer_def.h).  Each test is repeated BENCH_REPEAT
+// times in batch mode, so the result is the time to render into the screen buffer only,
+// except the last test which includes the display update (GDRAM write).
+// Results are reported in nanoseconds per call (core timer tick = 25ns @ 80MHz).
+//
+void RunBenchmark()
+{
+    static const char *testName[] =
+    {
+        "BlockFill 128 x 64",
+        "BlockFill 13 x 9 (unaligned)",
+        "PutImage 16 x 40 (aligned)",
+        "PutImage 44 x 44 (unaligned)",
+        "PutText 12p, 10 chars",
+        "InvertScreen 128 x 64",
+        "BlockFill + Flush 128 x 64"
+    };
+    char    textBuf[60];
+    uint32  startTime, cycles;
+    short   test, rep;
+
+#if defined (LCD_BUFFER_PAGE_MAJOR)
+    putstr("Screen buffer: page-major, 8-bit vertical bytes\n");
+#elif defined (LCD_BUFFER_WORD32)
+    putstr("Screen buffer: row-major, 32-bit column words\n");
+#else
+    putstr("Screen buffer: row-major, 16-bit column words\n");
+#endif
+    Disp_ClearScreen();
+    Disp_BeginBatch();
+    Disp_Mode(FLIP_PIXELS);
+    Disp_SetFont(PROP_12_NORM);
+
+    for (test = 0;  test < 7;  test++)
+    {
+        startTime = ReadCoreCountReg();
+
+        for (rep = 0;  rep < BENCH_REPEAT;  rep++)
+        {
+            switch (test)
+            {
+            case 0:  Disp_PosXY(0, 0);  Disp_BlockFill(128, 64);  break;
+            case 1:  Disp_PosXY(37, 21);  Disp_BlockFill(13, 9);  break;
+            case 2:  Disp_PosXY(48, 10);
+                     Disp_PutImage((bitmap_t *) treble_clef_16x40, 16, 40);  break;
+            case 3:  Disp_PosXY(37, 10);
+                     Disp_PutImage((bitmap_t *) chess_knight, 44, 44);  break;
+            case 4:  Disp_PosXY(4, 24);  Disp_PutText("0123456789");  break;
+            case 5:  Disp_InvertScreen();  break;
+            case 6:  Disp_PosXY(0, 0);  Disp_BlockFill(128, 64);  Disp_Flush();
+                     Disp_BeginBatch();  break;
+            }
+        }
+
+        cycles = ReadCoreCountReg() - startTime;
+        sprintf(textBuf, "%-30s %8lu ns\n", testName[test], (cycles / BENCH_REPEAT) * 25);
+        putstr(textBuf);
+    }
+
+    Disp_Mode(SET_PIXELS);
+    Disp_Flush();
+}
+
+
 // Function to test character generator functions in graphics library.
 // Font size should be 8 px (mono or prop).
 //
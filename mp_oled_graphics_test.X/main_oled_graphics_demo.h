@@ -29,6 +29,8 @@
 #define BUILD_VER_DEBUG   0
 
 //#define BUILD_OLED_GRAPHICS_TEST 
+
+#define BENCH_REPEAT  100   // Number of calls per benchmark test
 //
 // =======================================================================================
 
@@ -60,10 +62,12 @@
 void  DisplayHomeMessageScreen();
 void  DisplayTheQuickBrownFox();
 void  TestImagesScreenOne();
+void  DrawImagesScreenOne();
 void  TestImagesScreenTwo();
 void  Disp_TestCharGen(uint8 fontID);
 void  Disp_TestCharGen_8p(uint8 fontID);
 void  Disp_TestCharGen_12p(uint8 fontID, short page);
+void  RunBenchmark();
 void  ButtonScan();
 BOOL  getString(char *str, BYTE maxlen);
 void  BackgroundTaskExec();